@@ -0,0 +1,285 @@
+/**
+ * Microbenchmarks for the per-chunk kernels. Throughput is reported as voxels/sec (items_per_second); meshing
+ * benchmarks also report faces per chunk and bytes per face of the produced mesh.
+ */
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <iostream>
+
+#include "BlockProvider.h"
+#include "Chunk.h"
+#include "ChunkFixtures.h"
+#include "ChunkIO.h"
+#include "ChunkMesh.h"
+#include "Physics.h"
+#include "World.h"
+
+static void BM_GenerateData(benchmark::State& state)
+{
+	std::shared_ptr<Chunk> chunk = ChunkFixtures::Make(ChunkFixture::Empty, glm::ivec2(3, -7));
+	for (auto _ : state)
+	{
+		chunk->GenerateData();
+		benchmark::DoNotOptimize(ChunkFixtures::GetData(*chunk));
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * CHUNK_VOLUME);
+}
+BENCHMARK(BM_GenerateData);
+
+static void BM_GenerateMesh(benchmark::State& state, ChunkFixture fixture)
+{
+	glm::ivec2 pos(5, 9);
+	std::shared_ptr<Chunk> chunk = ChunkFixtures::Make(fixture, pos);
+	std::array<std::shared_ptr<Chunk>, 4> neighbors = ChunkFixtures::MakeNeighbors(fixture, pos);
+
+	unsigned int faces = 0;
+	size_t meshBytes = 0;
+	for (auto _ : state)
+	{
+		ChunkMesh* mesh = chunk->GenerateMesh(neighbors);
+		faces = mesh->vertexCount / 4;
+		meshBytes = mesh->dataIndex * sizeof(uint32_t) + mesh->indicesIndex * sizeof(uint16_t);
+		benchmark::DoNotOptimize(mesh->dataBuffer.data());
+		delete mesh;
+	}
+	state.SetItemsProcessed(state.iterations() * CHUNK_VOLUME);
+	state.SetBytesProcessed(state.iterations() * meshBytes);
+	state.counters["faces"] = faces;
+	state.counters["bytes_per_face"] = faces > 0 ? static_cast<double>(meshBytes) / faces : 0;
+}
+BENCHMARK_CAPTURE(BM_GenerateMesh, Empty, ChunkFixture::Empty);
+BENCHMARK_CAPTURE(BM_GenerateMesh, Flat, ChunkFixture::Flat);
+BENCHMARK_CAPTURE(BM_GenerateMesh, Noisy, ChunkFixture::Noisy);
+BENCHMARK_CAPTURE(BM_GenerateMesh, Checkerboard, ChunkFixture::Checkerboard);
+
+static void BM_AddFaceToMesh(benchmark::State& state)
+{
+	std::shared_ptr<Chunk> chunk = ChunkFixtures::Make(ChunkFixture::Checkerboard, glm::ivec2(0, 0));
+	ChunkMesh* mesh = new ChunkMesh;
+	// Every face of every solid checkerboard voxel: the most a single chunk mesh ever has to hold
+	const unsigned int maxFaces = (CHUNK_VOLUME / 2) * 6;
+
+	for (auto _ : state)
+	{
+		mesh->Clear();
+		for (unsigned int face = 0; face < maxFaces; face++)
+		{
+			unsigned int voxel = (face / 6) * 2;
+			glm::ivec3 pos(voxel / (CHUNK_HEIGHT * CHUNK_WIDTH), (voxel / CHUNK_WIDTH) % CHUNK_HEIGHT, voxel % CHUNK_WIDTH);
+			ChunkFixtures::AddFace(*chunk, pos, static_cast<FaceDirection>(face % 6), mesh);
+		}
+		benchmark::DoNotOptimize(mesh->dataBuffer.data());
+		benchmark::ClobberMemory();
+	}
+	mesh->UpdateIndices();
+	size_t meshBytes = mesh->dataIndex * sizeof(uint32_t) + mesh->indicesIndex * sizeof(uint16_t);
+	state.SetItemsProcessed(state.iterations() * maxFaces);
+	state.SetBytesProcessed(state.iterations() * meshBytes);
+	state.counters["bytes_per_face"] = static_cast<double>(meshBytes) / maxFaces;
+	delete mesh;
+}
+BENCHMARK(BM_AddFaceToMesh);
+
+// What a single block edit costs to remesh: the one section around it, plus splicing it into the upload buffer
+static void BM_RebuildMeshSection(benchmark::State& state, ChunkFixture fixture)
+{
+	glm::ivec2 pos(5, 9);
+	std::shared_ptr<Chunk> chunk = ChunkFixtures::Make(fixture, pos);
+	std::array<std::shared_ptr<Chunk>, 4> neighbors = ChunkFixtures::MakeNeighbors(fixture, pos);
+	ChunkMesh* mesh = chunk->GenerateMesh(neighbors);
+
+	for (auto _ : state)
+	{
+		chunk->RebuildMesh(neighbors, mesh, 1u << (CHUNK_HEIGHT / 2 / MESH_SECTION_HEIGHT));
+		benchmark::DoNotOptimize(mesh->dataBuffer.data());
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * CHUNK_WIDTH * MESH_SECTION_HEIGHT * CHUNK_WIDTH);
+	state.counters["faces"] = mesh->vertexCount / 4;
+	delete mesh;
+}
+BENCHMARK_CAPTURE(BM_RebuildMeshSection, Noisy, ChunkFixture::Noisy);
+BENCHMARK_CAPTURE(BM_RebuildMeshSection, Checkerboard, ChunkFixture::Checkerboard);
+
+static bool IsRenderCircleDrawn(World* world)
+{
+	int radius = world->GetRenderDistance();
+	for (int x = -radius; x <= radius; x++)
+	{
+		for (int z = -radius; z <= radius; z++)
+		{
+			if (x * x + z * z <= radius * radius + radius && !world->IsChunkDrawn(glm::ivec2(x, z)))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static World* GetLoadedWorld()
+{
+	World* world = ChunkFixtures::GetWorld();
+	// Stream in everything around the spawn once; rays and edits below stay well inside the render distance
+	while (!IsRenderCircleDrawn(world))
+	{
+		world->Update(0.f);
+	}
+	return world;
+}
+
+static void BM_RayCast(benchmark::State& state, glm::vec3 origin, glm::vec3 direction)
+{
+	World* world = GetLoadedWorld();
+	float dist = static_cast<float>(state.range(0));
+	unsigned int hits = 0;
+	for (auto _ : state)
+	{
+		RayCastHit hit;
+		hits += Physics::RayCast(origin, direction, hit, dist, world) ? 1 : 0;
+		benchmark::DoNotOptimize(hit);
+	}
+	// One voxel visited per unit of distance along the dominant axis
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+	state.counters["hit_rate"] = static_cast<double>(hits) / state.iterations();
+}
+BENCHMARK_CAPTURE(BM_RayCast, Down, glm::vec3(0.5f, 63.5f, 0.5f), glm::vec3(0.f, -1.f, 0.f))->Arg(10)->Arg(64);
+BENCHMARK_CAPTURE(BM_RayCast, SkyDiagonal, glm::vec3(0.5f, 62.5f, 0.5f), glm::normalize(glm::vec3(1.f, 0.f, 1.f)))->Arg(10)->Arg(64);
+
+// A physics style neighbourhood query: every block in a cube around a point that straddles four chunks
+static void BM_GetBlocks(benchmark::State& state)
+{
+	World* world = GetLoadedWorld();
+	const int radius = static_cast<int>(state.range(0));
+	std::vector<glm::ivec3> positions;
+	for (int x = -radius; x <= radius; x++)
+	{
+		for (int y = -radius; y <= radius; y++)
+		{
+			for (int z = -radius; z <= radius; z++)
+			{
+				positions.push_back(glm::ivec3(x, 40 + y, z));
+			}
+		}
+	}
+	std::vector<uint8_t> blocks(positions.size());
+	for (auto _ : state)
+	{
+		world->GetBlocks(positions.data(), positions.size(), blocks.data());
+		benchmark::DoNotOptimize(blocks.data());
+	}
+	state.SetItemsProcessed(state.iterations() * positions.size());
+}
+BENCHMARK(BM_GetBlocks)->Arg(2)->Arg(8);
+
+// An explosion sized fill straddling four chunks, alternating air and stone so no edit is a no-op
+static void BM_ApplyEdits(benchmark::State& state)
+{
+	World* world = GetLoadedWorld();
+	const int radius = static_cast<int>(state.range(0));
+	std::vector<BlockEdit> edits;
+	uint8_t block = BLOCK_AIR;
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		block = block == BLOCK_AIR ? BLOCK_STONE : BLOCK_AIR;
+		edits.clear();
+		for (int x = -radius; x <= radius; x++)
+		{
+			for (int y = -radius; y <= radius; y++)
+			{
+				for (int z = -radius; z <= radius; z++)
+				{
+					edits.push_back(BlockEdit{ glm::ivec3(x, 40 + y, z), block });
+				}
+			}
+		}
+		state.ResumeTiming();
+
+		world->ApplyEdits(edits);
+
+		state.PauseTiming();
+		// Lets the remesh jobs start, so the next iteration copies the chunks again like the next frame would
+		world->Update(0.f);
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations() * edits.size());
+}
+BENCHMARK(BM_ApplyEdits)->Arg(4)->Arg(8);
+
+// Fills a cube around block (8, 40, 8) of chunk (0, 0) and waits for the remeshed copy to be swapped in
+static void EditAndRemesh(World* world, int radius, uint8_t block)
+{
+	std::vector<BlockEdit> edits;
+	for (int x = -radius; x <= radius; x++)
+	{
+		for (int y = -radius; y <= radius; y++)
+		{
+			for (int z = -radius; z <= radius; z++)
+			{
+				edits.push_back(BlockEdit{ glm::ivec3(8 + x, 40 + y, 8 + z), block });
+			}
+		}
+	}
+	world->ApplyEdits(edits);
+	while (!world->_chunkEdits.empty())
+	{
+		world->Update(0.f);
+	}
+}
+
+// An edit inside one chunk through to its remesh; without a retained mesh every section of the chunk is rebuilt, not
+// just the ones the edit touches
+static void BM_EditRemesh(benchmark::State& state, MeshRetention retention)
+{
+	World* world = GetLoadedWorld();
+	MeshRetention previous = world->GetMeshRetention();
+	world->SetMeshRetention(retention);
+	const int radius = static_cast<int>(state.range(0));
+	uint8_t block = BLOCK_STONE;
+	// Settles the chunk into this retention mode
+	EditAndRemesh(world, radius, block);
+	for (auto _ : state)
+	{
+		block = block == BLOCK_AIR ? BLOCK_STONE : BLOCK_AIR;
+		EditAndRemesh(world, radius, block);
+	}
+	world->SetMeshRetention(previous);
+}
+BENCHMARK_CAPTURE(BM_EditRemesh, None, MeshRetention::None)->Arg(0)->Arg(4)->UseRealTime();
+BENCHMARK_CAPTURE(BM_EditRemesh, Compact, MeshRetention::Compact)->Arg(0)->Arg(4)->UseRealTime();
+
+// A save through the ChunkIO backend, waited on until it's written, then read back the way Bootstrap loads chunks
+static void BM_SaveLoadRoundTrip(benchmark::State& state)
+{
+	std::shared_ptr<Chunk> chunk = ChunkFixtures::Make(ChunkFixture::Noisy, glm::ivec2(1000, 1000));
+	std::array<uint8_t, CHUNK_VOLUME> loaded{};
+	for (auto _ : state)
+	{
+		ChunkIO::QueueSave(chunk);
+		ChunkIO::Drain();
+		bool ok = ChunkIO::LoadNow(chunk->_chunkPos, &loaded);
+		benchmark::DoNotOptimize(ok);
+	}
+	state.SetLabel(ChunkIO::GetBackendName());
+	state.SetItemsProcessed(state.iterations() * CHUNK_VOLUME);
+	state.SetBytesProcessed(state.iterations() * CHUNK_VOLUME * 2);
+}
+BENCHMARK(BM_SaveLoadRoundTrip)->UseRealTime();
+
+int main(int argc, char** argv)
+{
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv))
+	{
+		return 1;
+	}
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+
+	// JobSystem workers are detached and may still be meshing the fixture world; skip static destruction underneath them
+	std::cout.flush();
+	std::quick_exit(0);
+}
@@ -0,0 +1,97 @@
+#include "ChunkFixtures.h"
+
+#include <cstring>
+#include <filesystem>
+
+#include "BlockProvider.h"
+#include "ChunkGenerator.h"
+#include "ChunkIO.h"
+#include "ChunkResources.h"
+#include "GlobalEventManager.h"
+#include "JobSystem.h"
+#include "NullRenderBackend.h"
+#include "Player.h"
+#include "World.h"
+
+World* ChunkFixtures::GetWorld()
+{
+	static World* world = nullptr;
+	if (world == nullptr)
+	{
+		GlobalEventManager::Init();
+		JobSystem::Init();
+		BlockProvider::Init();
+		// Fresh folder so streamed chunks are always generated, never read back from an earlier run
+		std::string saveFolder = (std::filesystem::temp_directory_path() / "bosscraft_fixture_chunks").string();
+		std::error_code err;
+		std::filesystem::remove_all(saveFolder, err);
+		ChunkResources::Init(saveFolder);
+		ChunkIO::Init();
+		world = new World(new NullRenderBackend(), new Player(glm::vec3(0, 64, 0)));
+	}
+	return world;
+}
+
+std::shared_ptr<Chunk> ChunkFixtures::Make(ChunkFixture fixture, glm::ivec2 chunkPos)
+{
+	std::shared_ptr<Chunk> chunk = std::make_shared<Chunk>(chunkPos, GetWorld());
+	std::array<uint8_t, CHUNK_VOLUME> blocks;
+	uint8_t* data = blocks.data();
+
+	switch (fixture)
+	{
+	case ChunkFixture::Empty:
+		memset(data, 0, CHUNK_VOLUME);
+		break;
+	case ChunkFixture::Flat:
+		for (unsigned int x = 0; x < CHUNK_WIDTH; x++)
+		{
+			for (unsigned int y = 0; y < CHUNK_HEIGHT; y++)
+			{
+				for (unsigned int z = 0; z < CHUNK_WIDTH; z++)
+				{
+					data[chunk->PositionToIndex(x, y, z)] = y < CHUNK_HEIGHT / 2 ? 1 : 0;
+				}
+			}
+		}
+		break;
+	case ChunkFixture::Noisy:
+		GetWorld()->_chunkGenerator->Generate(chunkPos, data);
+		break;
+	case ChunkFixture::Checkerboard:
+		for (unsigned int x = 0; x < CHUNK_WIDTH; x++)
+		{
+			for (unsigned int y = 0; y < CHUNK_HEIGHT; y++)
+			{
+				for (unsigned int z = 0; z < CHUNK_WIDTH; z++)
+				{
+					data[chunk->PositionToIndex(x, y, z)] = ((x + y + z) % 2 == 0) ? 3 : 0;
+				}
+			}
+		}
+		break;
+	}
+	chunk->SetBlocks(data);
+	chunk->_isDirty = false;
+	return chunk;
+}
+
+std::array<std::shared_ptr<Chunk>, 4> ChunkFixtures::MakeNeighbors(ChunkFixture fixture, glm::ivec2 chunkPos)
+{
+	return {
+		Make(fixture, glm::ivec2(chunkPos[0] + 1, chunkPos[1])),
+		Make(fixture, glm::ivec2(chunkPos[0] - 1, chunkPos[1])),
+		Make(fixture, glm::ivec2(chunkPos[0], chunkPos[1] + 1)),
+		Make(fixture, glm::ivec2(chunkPos[0], chunkPos[1] - 1)),
+	};
+}
+
+void ChunkFixtures::AddFace(Chunk& chunk, glm::ivec3 blockPos, FaceDirection direction, ChunkMesh* mesh)
+{
+	chunk.AddFaceToMesh(blockPos, static_cast<uint8_t>(chunk.GetDataAtPosition(blockPos)), direction, mesh);
+}
+
+const uint8_t* ChunkFixtures::GetData(Chunk& chunk)
+{
+	return chunk.GetSectionData(0);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <memory>
+
+#include "Chunk.h"
+#include "ChunkMesh.h"
+
+class World;
+
+enum class ChunkFixture
+{
+	Empty,
+	Flat,
+	Noisy,
+	// Every other voxel solid in all three axes; every solid voxel shows all six faces
+	Checkerboard,
+};
+
+/**
+ * Fixed corpus of chunks for the microbenchmarks. Friend of Chunk so fixtures can write block data directly.
+ */
+class ChunkFixtures
+{
+public:
+	// A headless World (null render backend, systems initialized) that fixture chunks belong to
+	static World* GetWorld();
+
+	static std::shared_ptr<Chunk> Make(ChunkFixture fixture, glm::ivec2 chunkPos);
+	static std::array<std::shared_ptr<Chunk>, 4> MakeNeighbors(ChunkFixture fixture, glm::ivec2 chunkPos);
+
+	static void AddFace(Chunk& chunk, glm::ivec3 blockPos, FaceDirection direction, ChunkMesh* mesh);
+	static const uint8_t* GetData(Chunk& chunk);
+};
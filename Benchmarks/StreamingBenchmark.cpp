@@ -0,0 +1,394 @@
+/**
+ * Deterministic world-streaming benchmark. Flies a scripted camera path through a seeded world with the null render
+ * backend and prints throughput, frame time percentiles and peak RSS as JSON.
+ *
+ *   bosscraft_streaming_bench [--frames N] [--seed S] [--speed blocksPerSecond] [--fps N] [--save-dir DIR] [--out FILE]
+ *                             [--trace FILE] [--metrics FILE] [--render-distance N] [--load-margin N]
+ *                             [--memory-budget-mb N]
+ *                             [--mesh-retention none|compact] [--teleport-at FRAME]
+ *                             [--view-distance-at FRAME:RENDER_DISTANCE:LOAD_MARGIN]
+ *
+ * Frames are paced to --fps (default 60, 0 = run flat out) so workers get the same wall time per frame as in the client.
+ * first_ground_ms is how long after spawn the chunks around the camera were first all drawn. holes_ahead_mean counts, per
+ * frame after that, the chunks in front of the camera and inside the render distance that aren't drawn yet, and
+ * nearest_hole_ahead is how close the closest of those ever got, in chunks. peak_budgeted_bytes is the highest
+ * MemoryBudget total seen at the end of a frame.
+ *
+ * --teleport-at jumps the camera far outside the window at that frame and --view-distance-at calls SetViewDistance at
+ * that frame, e.g. 300:4:2 to drop most of the window at once. After the last frame the world is left to settle
+ * until every chunk it dropped has been destroyed; by then each resident chunk holds exactly one set of render buffers,
+ * so buffers_leaked (created - destroyed - resident) must be 0, and the GPU bytes MemoryBudget counts must match what
+ * the backend still holds (gpu_bytes_mismatch). The exit code is 1 if either is off or the world never settled.
+ * Run with --memory-budget-mb to check eviction frees what it accounts for.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "BlockProvider.h"
+#include "Camera.h"
+#include "ChunkIO.h"
+#include "ChunkPool.h"
+#include "ChunkResources.h"
+#include "GlobalEventManager.h"
+#include "JobSystem.h"
+#include "MemoryBudget.h"
+#include "NullRenderBackend.h"
+#include "Metrics.h"
+#include "Player.h"
+#include "Profiler.h"
+#include "World.h"
+
+struct BenchmarkOptions
+{
+	unsigned int frames = 1200;
+	int seed = 1337;
+	float speed = 50.f;
+	float dt = 1.f / 60.f;
+	unsigned int fps = 60;
+	// 0 keeps the world's defaults
+	unsigned int renderDistance = 0;
+	unsigned int loadMargin = 0;
+	// 0 is no budget
+	unsigned int memoryBudgetMb = 0;
+	MeshRetention meshRetention = MeshRetention::Compact;
+	// 0 never teleports
+	unsigned int teleportAt = 0;
+	// 0 never changes the view distance
+	unsigned int viewDistanceAt = 0;
+	unsigned int viewRenderDistance = 0;
+	unsigned int viewLoadMargin = 0;
+	std::string saveDir = "bench_chunks";
+	std::string outPath;
+	std::string tracePath;
+	std::string metricsPath;
+};
+
+static uint64_t PeakRssBytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters{};
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+	return counters.PeakWorkingSetSize;
+#else
+	rusage usage{};
+	getrusage(RUSAGE_SELF, &usage);
+	// ru_maxrss is in kilobytes on Linux
+	return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+static double Percentile(std::vector<double> values, double p)
+{
+	if (values.empty())
+	{
+		return 0;
+	}
+	std::sort(values.begin(), values.end());
+	size_t index = static_cast<size_t>(std::ceil(p * values.size())) - 1;
+	return values[std::min(index, values.size() - 1)];
+}
+
+/**
+ * The path is a function of the frame index only, so every run visits the same chunks in the same order:
+ * a straight run along +x, a quarter turn, then a run along +z.
+ */
+static glm::vec3 CameraPathPosition(unsigned int frame, const BenchmarkOptions& options)
+{
+	float step = options.speed * options.dt;
+	unsigned int leg = options.frames / 2;
+	// Far enough that nothing of the old window is kept
+	glm::vec3 teleport(options.teleportAt > 0 && frame >= options.teleportAt ? 16384.f : 0.f, 0.f, 0.f);
+	if (frame < leg)
+	{
+		return glm::vec3(frame * step, 64.f, 0.f) + teleport;
+	}
+	return glm::vec3(leg * step, 64.f, (frame - leg) * step) + teleport;
+}
+
+// The camera's chunk and the eight around it
+static bool GroundIsDrawn(World* world, glm::vec3 cameraPos)
+{
+	glm::ivec2 center = world->BlockPosToAbsChunkPos(glm::ivec3(glm::floor(cameraPos)));
+	for (int x = -1; x <= 1; x++)
+	{
+		for (int z = -1; z <= 1; z++)
+		{
+			if (!world->IsChunkDrawn(center + glm::ivec2(x, z)))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static bool ParseOptions(int argc, char** argv, BenchmarkOptions& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (i + 1 >= argc)
+		{
+			std::cerr << "Missing value for " << arg << std::endl;
+			return false;
+		}
+		std::string value = argv[++i];
+		if (arg == "--frames") options.frames = static_cast<unsigned int>(std::stoul(value));
+		else if (arg == "--seed") options.seed = std::stoi(value);
+		else if (arg == "--speed") options.speed = std::stof(value);
+		else if (arg == "--fps") options.fps = static_cast<unsigned int>(std::stoul(value));
+		else if (arg == "--save-dir") options.saveDir = value;
+		else if (arg == "--out") options.outPath = value;
+		else if (arg == "--trace") options.tracePath = value;
+		else if (arg == "--metrics") options.metricsPath = value;
+		else if (arg == "--render-distance") options.renderDistance = static_cast<unsigned int>(std::stoul(value));
+		else if (arg == "--load-margin") options.loadMargin = static_cast<unsigned int>(std::stoul(value));
+		else if (arg == "--memory-budget-mb") options.memoryBudgetMb = static_cast<unsigned int>(std::stoul(value));
+		else if (arg == "--mesh-retention" && value == "none") options.meshRetention = MeshRetention::None;
+		else if (arg == "--mesh-retention" && value == "compact") options.meshRetention = MeshRetention::Compact;
+		else if (arg == "--teleport-at") options.teleportAt = static_cast<unsigned int>(std::stoul(value));
+		else if (arg == "--view-distance-at")
+		{
+			if (std::sscanf(value.c_str(), "%u:%u:%u", &options.viewDistanceAt, &options.viewRenderDistance,
+				&options.viewLoadMargin) != 3)
+			{
+				std::cerr << "Expected FRAME:RENDER_DISTANCE:LOAD_MARGIN for " << arg << std::endl;
+				return false;
+			}
+		}
+		else
+		{
+			std::cerr << "Unknown option " << arg << std::endl;
+			return false;
+		}
+	}
+	if (options.fps > 0)
+	{
+		options.dt = 1.f / options.fps;
+	}
+	return true;
+}
+
+// Undrawn chunks inside the render distance in front of the camera along heading; nearest is lowered to the closest
+static int HolesAhead(World* world, glm::vec3 cameraPos, glm::vec2 heading, float& nearest)
+{
+	glm::ivec2 center = world->BlockPosToAbsChunkPos(glm::ivec3(glm::floor(cameraPos)));
+	int radius = world->GetRenderDistance();
+	int holes = 0;
+	for (int x = -radius; x <= radius; x++)
+	{
+		for (int z = -radius; z <= radius; z++)
+		{
+			if (x * x + z * z > radius * radius + radius || x * heading.x + z * heading.y <= 0)
+			{
+				continue;
+			}
+			if (!world->IsChunkDrawn(center + glm::ivec2(x, z)))
+			{
+				holes++;
+				nearest = std::min(nearest, std::sqrt(static_cast<float>(x * x + z * z)));
+			}
+		}
+	}
+	return holes;
+}
+
+int main(int argc, char** argv)
+{
+	BenchmarkOptions options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		return 1;
+	}
+
+	// Start from an empty save folder so every chunk takes the generation path
+	std::error_code err;
+	std::filesystem::remove_all(options.saveDir, err);
+
+	GlobalEventManager::Init();
+	JobSystem::Init();
+	BlockProvider::Init();
+	ChunkResources::Init(options.saveDir);
+	ChunkIO::Init();
+	MemoryBudget::SetLimit(static_cast<uint64_t>(options.memoryBudgetMb) << 20);
+
+	NullRenderBackend* renderBackend = new NullRenderBackend();
+	Player* player = new Player(CameraPathPosition(0, options));
+	// Never destroyed: chunks hand their buffers back to the world from their destructors
+	World* world = new World(renderBackend, player);
+	world->_noiseGenerator->SetSeed(options.seed);
+	world->SetMeshRetention(options.meshRetention);
+	if (options.renderDistance > 0 || options.loadMargin > 0)
+	{
+		world->SetViewDistance(
+			static_cast<uint8_t>(options.renderDistance > 0 ? options.renderDistance : world->GetRenderDistance()),
+			static_cast<uint8_t>(options.loadMargin > 0 ? options.loadMargin : world->GetExtraLoadDistance()));
+	}
+
+	std::vector<double> frameTimesMs;
+	frameTimesMs.reserve(options.frames);
+
+	PROFILE_THREAD_NAME("Main");
+	if (!options.tracePath.empty())
+	{
+#ifndef BOSSCRAFT_PROFILE
+		std::cerr << "Profiler zones are compiled out; configure with BOSSCRAFT_ENABLE_PROFILER=ON for a useful trace" << std::endl;
+#endif
+		Profiler::BeginCapture();
+	}
+
+	auto runStart = std::chrono::steady_clock::now();
+	double firstGroundMs = -1;
+	int firstGroundFrame = -1;
+	uint64_t holesAhead = 0;
+	unsigned int holeFrames = 0;
+	uint64_t peakBudgetedBytes = 0;
+	float nearestHoleAhead = static_cast<float>(world->GetRenderDistance() + 1);
+	for (unsigned int frame = 0; frame < options.frames; frame++)
+	{
+		auto frameStart = std::chrono::steady_clock::now();
+		PROFILE_SCOPE("Frame");
+
+		glm::vec3 pos = CameraPathPosition(frame, options);
+		player->_worldPos = pos;
+		player->_camera->UpdatePos(pos);
+		if (frame == options.teleportAt && frame > 0)
+		{
+			world->Teleport(pos);
+		}
+		else
+		{
+			world->SetCenter(pos);
+		}
+		if (frame == options.viewDistanceAt && frame > 0)
+		{
+			world->SetViewDistance(static_cast<uint8_t>(options.viewRenderDistance), static_cast<uint8_t>(options.viewLoadMargin));
+		}
+		GlobalEventManager::ProcessEvents();
+		world->Update(options.dt);
+
+		auto frameEnd = std::chrono::steady_clock::now();
+		peakBudgetedBytes = std::max(peakBudgetedBytes, MemoryBudget::GetTotalBytes());
+		if (firstGroundFrame < 0 && GroundIsDrawn(world, pos))
+		{
+			firstGroundFrame = static_cast<int>(frame);
+			firstGroundMs = std::chrono::duration<double, std::milli>(frameEnd - runStart).count();
+		}
+		else if (firstGroundFrame >= 0 && frame != options.teleportAt)
+		{
+			glm::vec3 step = pos - CameraPathPosition(frame - 1, options);
+			holesAhead += HolesAhead(world, pos, glm::vec2(step.x, step.z), nearestHoleAhead);
+			holeFrames++;
+		}
+		frameTimesMs.emplace_back(std::chrono::duration<double, std::milli>(frameEnd - frameStart).count());
+
+		if (options.fps > 0)
+		{
+			std::this_thread::sleep_until(frameStart + std::chrono::microseconds(1000000 / options.fps));
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+
+	// Chunks still loading, or dropped but still held by a job or a save, keep the pool above the grid
+	const unsigned int maxSettleFrames = 3000;
+	unsigned int settleFrames = 0;
+	while (settleFrames < maxSettleFrames && world->_chunkPool->GetLiveCount() != world->GetResidentChunkCount())
+	{
+		GlobalEventManager::ProcessEvents();
+		world->Update(options.dt);
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		settleFrames++;
+	}
+	bool settled = settleFrames < maxSettleFrames;
+	// The last chunks destroyed queued their buffers after that Update
+	world->Update(options.dt);
+
+	if (!options.tracePath.empty())
+	{
+		Profiler::EndCapture();
+		Profiler::WriteChromeTrace(options.tracePath);
+	}
+
+	if (!options.metricsPath.empty())
+	{
+		Metrics::WriteJson(options.metricsPath);
+	}
+
+	const WorldStats& worldStats = world->GetStats();
+	const RenderStats& renderStats = renderBackend->GetStats();
+	uint64_t residentChunks = world->GetResidentChunkCount();
+	uint64_t buffersLive = renderStats.buffersCreated - renderStats.buffersDestroyed;
+	int64_t buffersLeaked = static_cast<int64_t>(buffersLive) - static_cast<int64_t>(residentChunks);
+	uint64_t budgetedGpuBytes = MemoryBudget::GetBytes(MemoryCategory::GpuBuffers);
+	int64_t gpuBytesMismatch = static_cast<int64_t>(renderStats.bytesResident) - static_cast<int64_t>(budgetedGpuBytes);
+
+	std::stringstream json;
+	json << "{\n"
+		<< "  \"frames\": " << options.frames << ",\n"
+		<< "  \"seed\": " << options.seed << ",\n"
+		<< "  \"speed\": " << options.speed << ",\n"
+		<< "  \"fps\": " << options.fps << ",\n"
+		<< "  \"render_distance\": " << static_cast<int>(world->GetRenderDistance()) << ",\n"
+		<< "  \"io_backend\": \"" << ChunkIO::GetBackendName() << "\",\n"
+		<< "  \"seconds\": " << seconds << ",\n"
+		<< "  \"chunks_generated\": " << worldStats.chunksLoaded << ",\n"
+		<< "  \"chunks_meshed\": " << worldStats.meshesBuilt << ",\n"
+		<< "  \"chunks_uploaded\": " << renderStats.uploads << ",\n"
+		<< "  \"chunks_unloaded\": " << worldStats.chunksUnloaded << ",\n"
+		<< "  \"chunks_generated_per_sec\": " << worldStats.chunksLoaded / seconds << ",\n"
+		<< "  \"chunks_meshed_per_sec\": " << worldStats.meshesBuilt / seconds << ",\n"
+		<< "  \"chunks_uploaded_per_sec\": " << renderStats.uploads / seconds << ",\n"
+		<< "  \"bytes_uploaded\": " << renderStats.bytesUploaded << ",\n"
+		<< "  \"draws\": " << renderStats.draws << ",\n"
+		<< "  \"first_ground_frame\": " << firstGroundFrame << ",\n"
+		<< "  \"first_ground_ms\": " << firstGroundMs << ",\n"
+		<< "  \"holes_ahead_mean\": " << (holeFrames > 0 ? static_cast<double>(holesAhead) / holeFrames : 0) << ",\n"
+		<< "  \"nearest_hole_ahead\": " << nearestHoleAhead << ",\n"
+		<< "  \"frame_ms_p50\": " << Percentile(frameTimesMs, 0.50) << ",\n"
+		<< "  \"frame_ms_p99\": " << Percentile(frameTimesMs, 0.99) << ",\n"
+		<< "  \"frame_ms_max\": " << Percentile(frameTimesMs, 1.0) << ",\n"
+		<< "  \"peak_budgeted_bytes\": " << peakBudgetedBytes << ",\n"
+		<< "  \"peak_rss_bytes\": " << PeakRssBytes() << ",\n"
+		<< "  \"settled\": " << (settled ? "true" : "false") << ",\n"
+		<< "  \"chunks_resident\": " << residentChunks << ",\n"
+		<< "  \"buffers_created\": " << renderStats.buffersCreated << ",\n"
+		<< "  \"buffers_destroyed\": " << renderStats.buffersDestroyed << ",\n"
+		<< "  \"buffers_live\": " << buffersLive << ",\n"
+		<< "  \"buffers_leaked\": " << buffersLeaked << ",\n"
+		<< "  \"gpu_bytes_resident\": " << renderStats.bytesResident << ",\n"
+		<< "  \"gpu_bytes_budgeted\": " << budgetedGpuBytes << ",\n"
+		<< "  \"gpu_bytes_mismatch\": " << gpuBytesMismatch << "\n"
+		<< "}\n";
+
+	if (options.outPath.empty())
+	{
+		std::cout << json.str();
+	}
+	else
+	{
+		std::ofstream out(options.outPath);
+		out << json.str();
+	}
+
+	// Workers are detached and still hold chunks; skip static destruction underneath them
+	std::cout.flush();
+	std::quick_exit(settled && buffersLeaked == 0 && gpuBytesMismatch == 0 ? 0 : 1);
+}
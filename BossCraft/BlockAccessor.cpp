@@ -0,0 +1,32 @@
+#include "BlockAccessor.h"
+
+#include "ChunkGrid.h"
+#include "World.h"
+
+BlockAccessor::BlockAccessor(World* world) : _chunks(&world->_chunks)
+{
+	_cachedChunkPos = glm::ivec2(0, 0);
+	_cachedSections.fill(NULL);
+	_hasCache = false;
+}
+
+void BlockAccessor::GetBlocks(const glm::ivec3* positions, size_t count, uint8_t* out)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		out[i] = GetBlock(positions[i]);
+	}
+}
+
+void BlockAccessor::CacheChunk(glm::ivec2 chunkPos)
+{
+	// Find, not Get: no shared_ptr copy, and the grid is never written
+	ChunkGrid::Slot* slot = _chunks->Find(chunkPos);
+	Chunk* chunk = slot != NULL ? slot->chunk.get() : NULL;
+	for (unsigned int section = 0; section < CHUNK_SECTION_COUNT; section++)
+	{
+		_cachedSections[section] = chunk != NULL ? chunk->_sections[section]->data() : NULL;
+	}
+	_cachedChunkPos = chunkPos;
+	_hasCache = true;
+}
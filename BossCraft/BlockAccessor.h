@@ -0,0 +1,60 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include "Chunk.h"
+
+class ChunkGrid;
+class World;
+
+/**
+ * Read only block lookups for the main thread, e.g. one per ray step. Chunk coordinates come from shifts and masks and
+ * the last chunk looked up is remembered, so a run of lookups in one chunk never touches the chunk grid. Nothing is
+ * loaded or inserted: blocks outside the world or in chunks that aren't loaded read as air.
+ *
+ * Holds raw pointers to block sections, so don't keep one across World::Update (edits and unloads swap chunks out there).
+ */
+class BlockAccessor
+{
+private:
+	ChunkGrid* _chunks;
+	glm::ivec2 _cachedChunkPos;
+	// Sections of the cached chunk, all NULL if it isn't loaded
+	std::array<const uint8_t*, CHUNK_SECTION_COUNT> _cachedSections;
+	bool _hasCache;
+
+public:
+	explicit BlockAccessor(World* world);
+
+	uint8_t GetBlock(glm::ivec3 blockPos)
+	{
+		if (blockPos.y < 0 || blockPos.y >= static_cast<int>(CHUNK_HEIGHT))
+		{
+			return 0;
+		}
+
+		// Arithmetic shifts floor, so negative positions land in the right chunk
+		glm::ivec2 chunkPos(blockPos.x >> CHUNK_WIDTH_SHIFT, blockPos.z >> CHUNK_WIDTH_SHIFT);
+		if (!_hasCache || chunkPos != _cachedChunkPos)
+		{
+			CacheChunk(chunkPos);
+		}
+		unsigned int y = static_cast<unsigned int>(blockPos.y);
+		const uint8_t* section = _cachedSections[y / CHUNK_SECTION_HEIGHT];
+		if (section == NULL)
+		{
+			return 0;
+		}
+		return section[Chunk::SectionIndex(blockPos.x & (CHUNK_WIDTH - 1), y, blockPos.z & (CHUNK_WIDTH - 1))];
+	}
+
+	// out[i] = GetBlock(positions[i])
+	void GetBlocks(const glm::ivec3* positions, size_t count, uint8_t* out);
+
+private:
+	void CacheChunk(glm::ivec2 chunkPos);
+};
@@ -49,6 +49,31 @@ void BlockProvider::Init()
 		}
 	};
 
+	// Log
+	_blocks[4] = {
+		[](FaceDirection direction)
+		{
+			switch (direction)
+			{
+			case FaceDirection::UP:
+			case FaceDirection::DOWN:
+				return glm::ivec2(4, 3);
+			default:
+				return glm::ivec2(3, 3);
+			}
+		}
+	};
+
+	// Leaves
+	_blocks[5] = {
+		[](FaceDirection direction)
+		{
+			{
+			return glm::ivec2(7, 5);
+			}
+		}
+	};
+
 	
 }
 
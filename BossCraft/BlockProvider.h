@@ -1,9 +1,17 @@
 #pragma once
 #include <array>
+#include <cstdint>
 #include <functional>
 #include <glm/vec2.hpp>
 
-enum FaceDirection;
+#include "FaceDirection.h"
+
+const uint8_t BLOCK_AIR = 0;
+const uint8_t BLOCK_GRASS = 1;
+const uint8_t BLOCK_DIRT = 2;
+const uint8_t BLOCK_STONE = 3;
+const uint8_t BLOCK_LOG = 4;
+const uint8_t BLOCK_LEAVES = 5;
 
 enum class BlockTypes
 {
@@ -7,11 +7,17 @@
 #include <chrono>
 
 #include "BlockProvider.h"
+#include "ChunkIO.h"
 #include "ChunkResources.h"
+#include "GLRenderBackend.h"
 #include "GlobalEventManager.h"
 #include "JobSystem.h"
+#include "MemoryBudget.h"
 #include "FastNoiseLite.h"
+#include "Metrics.h"
 #include "Player.h"
+#include "Profiler.h"
+#include "Shader.h"
 #include "TextureAtlas.h"
 
 unsigned int SCREEN_WIDTH = 800;
@@ -51,6 +57,35 @@ void ScrollCallback(GLFWwindow* window, double xOffset, double yOffset)
 	world->GetCamera()->ProcessMouseScroll(yOffset);
 }
 
+// - and = step the render distance by one chunk; the load distance keeps its margin past it
+void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	if (action != GLFW_PRESS)
+	{
+		return;
+	}
+
+	int renderDistance = world->GetRenderDistance();
+	if (key == GLFW_KEY_MINUS)
+	{
+		renderDistance--;
+	}
+	else if (key == GLFW_KEY_EQUAL)
+	{
+		renderDistance++;
+	}
+	else
+	{
+		return;
+	}
+
+	if (renderDistance >= 1 && renderDistance + world->GetExtraLoadDistance() <= 64)
+	{
+		world->SetViewDistance(static_cast<uint8_t>(renderDistance), world->GetExtraLoadDistance());
+		std::cout << "Render distance " << renderDistance << std::endl;
+	}
+}
+
 GLFWwindow* CreateWindow()
 {
 	// Setup window
@@ -80,6 +115,7 @@ GLFWwindow* CreateWindow()
 
 	glfwSetCursorPosCallback(window, MouseMovedCallback);
 	glfwSetScrollCallback(window, ScrollCallback);
+	glfwSetKeyCallback(window, KeyCallback);
 
 	glEnable(GL_DEPTH_TEST);
 	glEnable(GL_CULL_FACE);
@@ -120,6 +156,7 @@ void RenderLoop(GLFWwindow* window)
 	int fpsCounts = 0;
 	while (!glfwWindowShouldClose(window))
 	{
+		PROFILE_SCOPE("Frame");
 		auto startTime = std::chrono::high_resolution_clock::now();
 		
 		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
@@ -171,6 +208,7 @@ void RenderLoop(GLFWwindow* window)
 		GlobalEventManager::ProcessEvents();
 		
 		world->Update(dt);
+		Metrics::Update(dt);
 
 		glfwSwapBuffers(window);
 		glfwPollEvents();
@@ -194,11 +232,18 @@ void RenderLoop(GLFWwindow* window)
 int main()
 {
     std::cout << "Hello World!\n";
+	PROFILE_THREAD_NAME("Main");
+#ifdef BOSSCRAFT_PROFILE
+	Profiler::BeginCapture();
+#endif
 	
 	GlobalEventManager::Init();
 	JobSystem::Init();
 	BlockProvider::Init();
 	ChunkResources::Init("chunks");
+	ChunkIO::Init();
+	Metrics::SetReportInterval(5.0f);
+	MemoryBudget::SetLimit(static_cast<uint64_t>(1024) << 20);
 	
 	GLFWwindow* window = CreateWindow();
 
@@ -207,7 +252,15 @@ int main()
 	//LoadTextureAtlas("Resources/atlas.png", &textureID, GL_RGBA, GL_CLAMP_TO_EDGE, &width, &height);
 	TextureAtlas* atlas = new TextureAtlas("Resources/atlas.png", 16, 16);
 	
-	world = new World(new Shader("Shaders\\vertex2.vs", "Shaders\\fragment2.fs"), atlas, new Player(glm::vec3(0, 64, 0)));
+	GLRenderBackend* renderBackend = new GLRenderBackend(new Shader("Shaders/vertex2.vs", "Shaders/fragment2.fs"), atlas);
+	world = new World(renderBackend, new Player(glm::vec3(0, 64, 0)));
 
 	RenderLoop(window);
+	// Chunks unloaded in the last frames are still being written
+	ChunkIO::Shutdown();
+
+#ifdef BOSSCRAFT_PROFILE
+	// Open in chrome://tracing or ui.perfetto.dev
+	Profiler::WriteChromeTrace("trace.json");
+#endif
 }
\ No newline at end of file
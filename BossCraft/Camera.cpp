@@ -32,7 +32,7 @@ void Camera::UpdatePos(glm::vec3 newPos)
     _position = newPos;
 }
 
-void Camera::ProcessMouseMovement(float xOffset, float yOffset, GLboolean constrainPitch)
+void Camera::ProcessMouseMovement(float xOffset, float yOffset, bool constrainPitch)
 {
     xOffset *= _mouseSensitivity;
     yOffset *= _mouseSensitivity;
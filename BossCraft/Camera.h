@@ -1,5 +1,4 @@
 #pragma once
-#include <glad/glad.h>
 #include <glm/mat4x2.hpp>
 #include <glm/ext/matrix_transform.hpp>
 
@@ -33,7 +32,7 @@ public:
 	
     void UpdatePos(glm::vec3 newPos);
 	
-    void ProcessMouseMovement(float xOffset, float yOffset, GLboolean constrainPitch);
+    void ProcessMouseMovement(float xOffset, float yOffset, bool constrainPitch);
 
     void ProcessMouseScroll(float yOffset);
 
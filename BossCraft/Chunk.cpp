@@ -1,53 +1,125 @@
 #include "Chunk.h"
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
+#include <cstring>
 #include <glm/mat4x4.hpp>
+#include <glm/ext/matrix_transform.hpp>
 
 #include "BlockProvider.h"
-#include "Shader.h"
 #include "Camera.h"
+#include "ChunkIO.h"
 #include "ChunkMesh.h"
-#include "ChunkResources.h"
+#include "ChunkPool.h"
 #include "FaceDirection.h"
-#include "TextureAtlas.h"
+#include "MemoryBudget.h"
+#include "ChunkGenerator.h"
+#include "Profiler.h"
 #include "World.h"
 
 Chunk::Chunk(glm::ivec2 chunkPos, World* owningWorld) : _chunkPos(chunkPos), _world(owningWorld)
 {
 	_isDirty = true;
-	_meshIsLoaded = false;
+	_state = ChunkState::Generating;
 
+	_renderHandle = {};
 	_indexCount = 0;
+	_uploadedBytes = 0;
 	_mesh = NULL;
+	_sections.fill(GetEmptySection());
 	_model = glm::mat4(1.f);
 	_model = glm::translate(_model, glm::vec3(_chunkPos[0] * 1.f * CHUNK_WIDTH, 0, _chunkPos[1] * 1.f * CHUNK_WIDTH));
 }
 
 Chunk::Chunk(Chunk& other)
 {
-	VAO = 0;
-	VBO = 0;
-	EBO = 0;
+	_renderHandle = {};
 	_indexCount = other._indexCount;
+	_uploadedBytes = 0;
 	_mesh = NULL;
 	_model = other._model;
 	
 	_world = other._world;
-	_data = other._data;
+	_sections = other._sections;
 	_chunkPos = other._chunkPos;
 	_isDirty = other._isDirty;
-	_meshIsLoaded = other._meshIsLoaded;
+	// The copy has new buffers, so nothing of it is uploaded yet
+	_state = ChunkState::Ready;
 }
 
 Chunk::~Chunk()
 {
-	_world->_chunkUnload.Enqueue(new std::array<unsigned int, 3>({ VAO, VBO, EBO }));
+	_world->ReleaseChunkBuffers(_renderHandle, _uploadedBytes);
 	delete _mesh;
 }
 
 void Chunk::SetData(glm::ivec3 blockPos, uint8_t blockType)
 {
-	_data[PositionToIndex(blockPos)] = blockType;
+	(*GetWritableSection(blockPos.y / CHUNK_SECTION_HEIGHT))[SectionIndex(blockPos.x, blockPos.y, blockPos.z)] = blockType;
+}
+
+void Chunk::SetBlocks(const uint8_t* blocks)
+{
+	for (unsigned int section = 0; section < CHUNK_SECTION_COUNT; section++)
+	{
+		// One row of CHUNK_SECTION_HEIGHT * CHUNK_WIDTH blocks per x in either layout
+		const size_t rowLength = CHUNK_SECTION_HEIGHT * CHUNK_WIDTH;
+		const uint8_t* first = blocks + section * rowLength;
+
+		bool air = true;
+		for (unsigned int x = 0; x < CHUNK_WIDTH && air; x++)
+		{
+			const uint8_t* row = first + x * CHUNK_HEIGHT * CHUNK_WIDTH;
+			air = row[0] == 0 && memcmp(row, row + 1, rowLength - 1) == 0;
+		}
+		if (air)
+		{
+			_sections[section] = GetEmptySection();
+			continue;
+		}
+
+		_sections[section] = _world->_chunkPool->AcquireSection();
+		for (unsigned int x = 0; x < CHUNK_WIDTH; x++)
+		{
+			memcpy(_sections[section]->data() + x * rowLength, first + x * CHUNK_HEIGHT * CHUNK_WIDTH, rowLength);
+		}
+	}
+}
+
+void Chunk::GetBlocks(uint8_t* out)
+{
+	const size_t rowLength = CHUNK_SECTION_HEIGHT * CHUNK_WIDTH;
+	for (unsigned int section = 0; section < CHUNK_SECTION_COUNT; section++)
+	{
+		for (unsigned int x = 0; x < CHUNK_WIDTH; x++)
+		{
+			memcpy(out + x * CHUNK_HEIGHT * CHUNK_WIDTH + section * rowLength, _sections[section]->data() + x * rowLength, rowLength);
+		}
+	}
+}
+
+const uint8_t* Chunk::GetSectionData(unsigned int section)
+{
+	return _sections[section]->data();
+}
+
+const std::shared_ptr<ChunkSection>& Chunk::GetEmptySection()
+{
+	static const std::shared_ptr<ChunkSection> empty = std::make_shared<ChunkSection>();
+	return empty;
+}
+
+/**
+ * The section, cloned first if anything else can see it. Only the main thread copies chunks, so a use count of one
+ * can't go up underneath the caller; a stale count above one only costs a needless clone.
+ */
+ChunkSection* Chunk::GetWritableSection(unsigned int section)
+{
+	std::shared_ptr<ChunkSection>& current = _sections[section];
+	if (current.use_count() != 1)
+	{
+		std::shared_ptr<ChunkSection> clone = _world->_chunkPool->AcquireSection();
+		*clone = *current;
+		current = clone;
+	}
+	return current.get();
 }
 
 unsigned int Chunk::PositionToIndex(unsigned int posX, unsigned int posY, unsigned int posZ)
@@ -68,45 +140,24 @@ glm::vec3 Chunk::IndexToPosition(unsigned int index)
 	return glm::vec3(x, y, z);
 }
 
-bool Chunk::BlockInChunkBounds(glm::ivec3 pos)
-{
-	return pos.x >= 0 && pos.y >= 0 && pos.z >= 0 &&
-		pos.x < CHUNK_WIDTH && pos.y < CHUNK_HEIGHT && pos.z < CHUNK_WIDTH;
-}
-
 /**
  * Re-Loads data into the data arrays if it is dirty -> Not main thread
  */
 void Chunk::LoadData()
 {
+	PROFILE_FUNCTION();
 	if (_isDirty)
 	{
-		bool loadedFromFile = ChunkResources::LoadChunk(_chunkPos, &_data);
+		std::array<uint8_t, CHUNK_VOLUME> blocks;
+		bool loadedFromFile = ChunkIO::LoadNow(_chunkPos, &blocks);
 
-		if (!loadedFromFile)
+		if (loadedFromFile)
 		{
-			for (unsigned int x = 0; x < CHUNK_WIDTH; x++)
-			{
-				for (unsigned int z = 0; z < CHUNK_WIDTH; z++)
-				{
-					float absX = static_cast<float>(x) + (static_cast<float>(_chunkPos[0]) * static_cast<float>(CHUNK_WIDTH));
-					float absZ = static_cast<float>(z) + (static_cast<float>(_chunkPos[1]) * static_cast<float>(CHUNK_WIDTH));
-					float noise = _world->_noiseGenerator->GetNoise(absX, absZ);
-					unsigned int normNoise = floor((noise + 1) * 5 + (CHUNK_HEIGHT / 2.f));
-					normNoise = std::min(normNoise, CHUNK_HEIGHT - 1);
-					for (unsigned int y = 0; y < CHUNK_HEIGHT; y++)
-					{
-						if (y < normNoise)
-						{
-							_data[PositionToIndex(x, y, z)] = 1;
-						}
-						else
-						{
-							_data[PositionToIndex(x, y, z)] = 0;
-						}
-					}
-				}
-			}
+			SetBlocks(blocks.data());
+		}
+		else
+		{
+			GenerateData();
 		}
 
 		// Unlock after use
@@ -114,90 +165,149 @@ void Chunk::LoadData()
 	}
 }
 
+/**
+ * Fills the data arrays with the world's generation pipeline -> Not main thread
+ */
+void Chunk::GenerateData()
+{
+	PROFILE_FUNCTION();
+	std::array<uint8_t, CHUNK_VOLUME> blocks;
+	_world->_chunkGenerator->Generate(_chunkPos, blocks.data());
+	SetBlocks(blocks.data());
+	_isDirty = false;
+}
+
 /**
  * Not main thread
  */
-ChunkMesh* Chunk::GenerateMesh(std::array<std::shared_ptr<Chunk>, 4> neighbors)
+ChunkMesh* Chunk::GenerateMesh(const std::array<std::shared_ptr<Chunk>, 4>& neighbors)
 {
+	PROFILE_FUNCTION();
 	ChunkMesh* mesh = new ChunkMesh;
-	// Generate Mesh
-	for (unsigned x = 0; x < CHUNK_WIDTH; x++)
+	RebuildMesh(neighbors, mesh, MESH_ALL_SECTIONS);
+	return mesh;
+}
+
+/**
+ * Rebuilds the sections of mesh set in sectionMask from this chunk's data, keeping the others -> Not main thread
+ */
+void Chunk::RebuildMesh(const std::array<std::shared_ptr<Chunk>, 4>& neighbors, ChunkMesh* mesh, unsigned int sectionMask)
+{
+	PROFILE_FUNCTION();
+	std::vector<uint32_t> previous;
+	previous.swap(mesh->dataBuffer);
+	std::array<unsigned int, MESH_SECTION_COUNT + 1> previousStart = mesh->sectionStart;
+	mesh->dataBuffer.reserve(previous.size());
+
+	for (unsigned int section = 0; section < MESH_SECTION_COUNT; section++)
+	{
+		mesh->sectionStart[section] = static_cast<unsigned int>(mesh->dataBuffer.size());
+		if (sectionMask & (1u << section))
+		{
+			BuildMeshSection(neighbors, mesh, section);
+		}
+		else
+		{
+			mesh->dataBuffer.insert(mesh->dataBuffer.end(), previous.begin() + previousStart[section], previous.begin() + previousStart[section + 1]);
+		}
+	}
+	mesh->sectionStart[MESH_SECTION_COUNT] = static_cast<unsigned int>(mesh->dataBuffer.size());
+	mesh->UpdateIndices();
+}
+
+void Chunk::BuildMeshSection(const std::array<std::shared_ptr<Chunk>, 4>& neighbors, ChunkMesh* mesh, unsigned int section)
+{
+	if (_sections[section] == GetEmptySection())
+	{
+		return;
+	}
+
+	// Faces look one block past the section: into the sections above and below, or the same section of a neighbour.
+	// NULL where there is nothing to look at, which leaves the face visible.
+	const uint8_t* blocks = _sections[section]->data();
+	const uint8_t* below = section > 0 ? _sections[section - 1]->data() : NULL;
+	const uint8_t* above = section + 1 < CHUNK_SECTION_COUNT ? _sections[section + 1]->data() : NULL;
+	std::array<const uint8_t*, 4> sides;
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		sides[i] = neighbors[i] != NULL ? neighbors[i]->_sections[section]->data() : NULL;
+	}
+
+	const int width = CHUNK_WIDTH;
+	const int height = CHUNK_SECTION_HEIGHT;
+	// Index steps to the neighbour in each FaceDirection, for blocks whose neighbours are all inside the section
+	const int step[6] = { -1, 1, height * width, -height * width, width, -width };
+	for (int x = 0; x < width; x++)
 	{
-		for (unsigned y = 0; y < CHUNK_HEIGHT; y++)
+		for (int y = 0; y < height; y++)
 		{
-			for (unsigned z = 0; z < CHUNK_WIDTH; z++)
+			for (int z = 0; z < width; z++)
 			{
-				glm::ivec3 pos(x, y, z);
-				glm::ivec3 wPos = pos + glm::ivec3(_chunkPos[0] * CHUNK_WIDTH, 0, _chunkPos[1] * CHUNK_WIDTH);
-				uint8_t data = _data[PositionToIndex(pos)];
+				unsigned int index = SectionIndex(x, y, z);
+				uint8_t data = blocks[index];
+				if (data == 0)
+				{
+					continue;
+				}
 
-				if (data != 0)
+				glm::ivec3 pos(x, section * CHUNK_SECTION_HEIGHT + y, z);
+				if (x > 0 && x < width - 1 && y > 0 && y < height - 1 && z > 0 && z < width - 1)
 				{
-					// loop over directions
 					for (int d = 0; d < 6; d++)
 					{
-						glm::ivec3 dirVec = DIRECTION_VEC[d];
-						glm::ivec3 neighbor = pos + dirVec;
-
-						bool visible = false;
-
-						if (BlockInChunkBounds(neighbor))
-						{
-							// determine if block is transparent (0 = transparent block)
-							visible = (_data[PositionToIndex(neighbor)] == 0);
-							//visible = true;
-						}
-						else
+						if (blocks[index + step[d]] == 0)
 						{
-							glm::ivec3 wNeighbor = wPos + dirVec;
-							
-							visible = true;
-
-							glm::ivec3 blockRelPos = AbsBlockPosToRelPos(wNeighbor);
-							// Figure out which neighbor to send it to
-							if (d == FaceDirection::EAST)
-							{
-								if (neighbors[0] != NULL)
-								{
-									visible = (GetNeighborBlockAtPos(blockRelPos, neighbors[0]->_data.data()) == 0);
-								}
-							}
-							else if (d == FaceDirection::WEST)
-							{
-								if (neighbors[1] != NULL)
-								{
-									visible = (GetNeighborBlockAtPos(blockRelPos, neighbors[1]->_data.data()) == 0);
-								}
-							}
-							else if (d == FaceDirection::SOUTH)
-							{
-								if (neighbors[2] != NULL)
-								{
-									visible = (GetNeighborBlockAtPos(blockRelPos, neighbors[2]->_data.data()) == 0);
-								}
-							}
-							else if (d == FaceDirection::NORTH)
-							{
-								if (neighbors[3] != NULL)
-								{
-									visible = (GetNeighborBlockAtPos(blockRelPos, neighbors[3]->_data.data()) == 0);
-								}
-							}
+							AddFaceToMesh(pos, data, static_cast<FaceDirection>(d), mesh);
 						}
+					}
+					continue;
+				}
 
-						if (visible)
-						{
-							AddFaceToMesh(pos, static_cast<FaceDirection>(d), mesh);
-						}
+				// loop over directions
+				for (int d = 0; d < 6; d++)
+				{
+					glm::ivec3 neighbor = glm::ivec3(x, y, z) + glm::ivec3(DIRECTION_VEC[d]);
+					const uint8_t* source = blocks;
+					if (neighbor.y < 0)
+					{
+						source = below;
+						neighbor.y += height;
+					}
+					else if (neighbor.y >= height)
+					{
+						source = above;
+						neighbor.y -= height;
+					}
+					else if (neighbor.x >= width)
+					{
+						source = sides[0];
+						neighbor.x -= width;
+					}
+					else if (neighbor.x < 0)
+					{
+						source = sides[1];
+						neighbor.x += width;
+					}
+					else if (neighbor.z >= width)
+					{
+						source = sides[2];
+						neighbor.z -= width;
+					}
+					else if (neighbor.z < 0)
+					{
+						source = sides[3];
+						neighbor.z += width;
+					}
+
+					// determine if block is transparent (0 = transparent block)
+					if (source == NULL || source[SectionIndex(neighbor.x, neighbor.y, neighbor.z)] == 0)
+					{
+						AddFaceToMesh(pos, data, static_cast<FaceDirection>(d), mesh);
 					}
 				}
 			}
 		}
 	}
-	//std::string output = "GenMesh: " + std::to_string(_chunkPos[0]) + ", " + std::to_string(_chunkPos[1]);
-	//std::cout << output << std::endl;
-	//std::cout << "Mesh" << std::endl;
-	return mesh;
 }
 
 void Chunk::GLLoad()
@@ -205,19 +315,7 @@ void Chunk::GLLoad()
 	//std::string output = "Load: " + std::to_string(_chunkPos[0]) + ", " + std::to_string(_chunkPos[1]);
 	//std::cout << output << std::endl;
 	
-	glGenVertexArrays(1, &VAO);
-	glGenBuffers(1, &VBO);
-	glGenBuffers(1, &EBO);
-
-	glBindVertexArray(VAO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	// position attribute
-	glVertexAttribPointer(0, 1, GL_FLOAT, GL_FALSE, sizeof(uint32_t), (void*)0);
-	glEnableVertexAttribArray(0);
-
-	glBindVertexArray(0);
-
-	_meshIsLoaded = true;
+	_renderHandle = _world->_renderBackend->CreateChunkBuffers();
 }
 
 void Chunk::GLUnload()
@@ -231,28 +329,22 @@ void Chunk::GLUnload()
 /**
  * Renders the ChunkMesh. MUST BE RUN ON MAIN THREAD
  */
-void Chunk::RenderMesh(Shader* shader)
+void Chunk::RenderMesh(IRenderBackend* renderBackend)
 {
-	if (!_meshIsLoaded)
+	if (_state != ChunkState::Uploaded)
 	{
 		return;
 	}
 	
-	shader->Use();
-
-	shader->SetModel(_model);
-	
-	glBindVertexArray(VAO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glDrawElements(GL_TRIANGLES, _indexCount, GL_UNSIGNED_SHORT, 0);
-	glBindVertexArray(0);
+	renderBackend->DrawChunk(_renderHandle, _model, _indexCount);
 }
 
-void Chunk::AddFaceToMesh(glm::ivec3 blockPos, FaceDirection direction, ChunkMesh* mesh)
+void Chunk::AddFaceToMesh(glm::ivec3 blockPos, uint8_t block, FaceDirection direction, ChunkMesh* mesh)
 {
-	TextureAtlas* atlas = _world->_textureAtlas;
-	unsigned char block = _data[PositionToIndex(blockPos)];
 	glm::ivec2 texCoords = BlockProvider::GetBlockTextureLocation(block, direction);
+	size_t first = mesh->dataBuffer.size();
+	mesh->dataBuffer.resize(first + 4);
+	uint32_t* vertices = &mesh->dataBuffer[first];
 	for (int i = 0; i < 4; i++)
 	{
 		uint32_t data = 0x00000000;
@@ -288,42 +380,58 @@ void Chunk::AddFaceToMesh(glm::ivec3 blockPos, FaceDirection direction, ChunkMes
 		data = data | ((0xFu & texCoords[1]) << 26u);
 		data = data | ((0x3u & valTimes10) << 30u);
 
-		mesh->dataBuffer[mesh->dataIndex++] = data;
-	}
-
-	for (int i = 0; i < 6; i++)
-	{
-		mesh->indexBuffer[mesh->indicesIndex++] = mesh->vertexCount + FACE_INDICES[i];
+		vertices[i] = data;
 	}
 
-	mesh->vertexCount += 4;
 }
 
 void Chunk::BufferMesh()
 {
+	PROFILE_FUNCTION();
 	//std::string output = "BufferMesh: " + std::to_string(_chunkPos[0]) + ", " + std::to_string(_chunkPos[1]);
 	//std::cout << output << std::endl;
+	// A retained compact mesh has no indices
+	_mesh->UpdateIndices();
 	_indexCount = _mesh->indicesIndex;
-	
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, _mesh->dataIndex * sizeof(uint32_t), _mesh->dataBuffer, GL_STATIC_DRAW);
-	
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, _indexCount * sizeof(uint16_t), _mesh->indexBuffer, GL_STATIC_DRAW);
-}
 
+	_world->_renderBackend->UploadChunkMesh(_renderHandle, _mesh->dataBuffer.data(), _mesh->dataIndex, _mesh->indexBuffer.data(), _indexCount);
+	SetUploadedBytes(_mesh->dataIndex * sizeof(uint32_t) + _indexCount * sizeof(uint16_t));
+	_state = ChunkState::Uploaded;
+
+	// The GPU has its own copy now
+	if (_world->GetMeshRetention() == MeshRetention::Compact)
+	{
+		_mesh->Compact();
+	}
+	else
+	{
+		delete _mesh;
+		_mesh = NULL;
+	}
+}
 
-unsigned Chunk::GetDataAtPosition(glm::vec3 pos)
+/**
+ * Drops the mesh and empties the uploaded buffers; the chunk is Ready again and has to be meshed to be drawn.
+ * MUST BE RUN ON MAIN THREAD
+ */
+void Chunk::ReleaseMesh()
 {
-	return _data[PositionToIndex(pos)];
+	delete _mesh;
+	_mesh = NULL;
+	_indexCount = 0;
+	_world->_renderBackend->UploadChunkMesh(_renderHandle, NULL, 0, NULL, 0);
+	SetUploadedBytes(0);
+	_state = ChunkState::Ready;
 }
 
-glm::ivec3 Chunk::AbsBlockPosToRelPos(glm::ivec3 blockPos)
+void Chunk::SetUploadedBytes(size_t bytes)
 {
-	return glm::ivec3(blockPos.x % CHUNK_WIDTH, blockPos.y, blockPos.z % CHUNK_WIDTH);
+	MemoryBudget::Add(MemoryCategory::GpuBuffers, static_cast<int64_t>(bytes) - static_cast<int64_t>(_uploadedBytes));
+	_uploadedBytes = bytes;
 }
 
-uint8_t Chunk::GetNeighborBlockAtPos(glm::ivec3 pos, uint8_t* neighborData)
+
+unsigned Chunk::GetDataAtPosition(glm::ivec3 pos)
 {
-	return neighborData[PositionToIndex(pos)];
+	return (*_sections[pos.y / CHUNK_SECTION_HEIGHT])[SectionIndex(pos.x, pos.y, pos.z)];
 }
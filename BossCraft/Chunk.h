@@ -1,38 +1,73 @@
 #pragma once
 #include <array>
+#include <atomic>
+#include <memory>
 #include <glm/vec3.hpp>
 #include <glm/vec2.hpp>
 #include <glm/mat4x4.hpp>
 #include "FaceDirection.h"
+#include "IRenderBackend.h"
 #include <mutex>
 
 class ChunkGenerator;
-class Shader;
 class Camera;
 // Chunks are 16x128x16
 const unsigned CHUNK_WIDTH = 16;
 const unsigned CHUNK_HEIGHT = 64;
 const unsigned int CHUNK_VOLUME = CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_WIDTH;
+// log2(CHUNK_WIDTH), for turning block coordinates into chunk coordinates with a shift
+const unsigned int CHUNK_WIDTH_SHIFT = 4;
+static_assert(1u << CHUNK_WIDTH_SHIFT == CHUNK_WIDTH, "CHUNK_WIDTH_SHIFT must match CHUNK_WIDTH");
+// Blocks are stored, copied and meshed in sections of 16 block tall slabs
+const unsigned int CHUNK_SECTION_HEIGHT = 16;
+const unsigned int CHUNK_SECTION_COUNT = CHUNK_HEIGHT / CHUNK_SECTION_HEIGHT;
+const unsigned int CHUNK_SECTION_VOLUME = CHUNK_WIDTH * CHUNK_SECTION_HEIGHT * CHUNK_WIDTH;
+
+// Indexed [x * CHUNK_SECTION_HEIGHT * CHUNK_WIDTH + (y % CHUNK_SECTION_HEIGHT) * CHUNK_WIDTH + z]
+typedef std::array<uint8_t, CHUNK_SECTION_VOLUME> ChunkSection;
 
 class World;
 struct ChunkMesh;
 
+// Where a chunk is in its life. Only the main thread moves a chunk along; jobs read it to drop work nobody will use.
+enum class ChunkState : uint8_t
+{
+	// Blocks are being loaded or generated
+	Generating,
+	// Blocks are valid, no mesh has been uploaded
+	Ready,
+	// A mesh job has the chunk
+	Meshing,
+	// Mesh is in the chunk's buffers and gets drawn
+	Uploaded,
+	// Left the window; waits for the jobs and saves still holding it
+	Unloading
+};
+
 class Chunk
 {
 	friend class World;
 	friend class ChunkResources;
+	friend class ChunkIO;
+	friend class ChunkFixtures;
+	friend class BlockAccessor;
 private:
-	unsigned int VAO, VBO, EBO;
+	ChunkRenderHandle _renderHandle;
 	unsigned int _indexCount;
+	// Size of the last upload, as counted by MemoryBudget
+	size_t _uploadedBytes;
+	// Only between meshing and upload, unless the world retains compact meshes
 	ChunkMesh* _mesh;
 	glm::mat4 _model;
 	
 	World* _world;
-	std::array<uint8_t, CHUNK_VOLUME> _data;
+	// Shared with copies of the chunk and never written while shared, so readers holding the chunk see a fixed
+	// snapshot. SetData clones the one section it writes to; all air sections share one empty section.
+	std::array<std::shared_ptr<ChunkSection>, CHUNK_SECTION_COUNT> _sections;
 public:
 	glm::ivec2 _chunkPos;
 	bool _isDirty;
-	bool _meshIsLoaded;
+	std::atomic<ChunkState> _state;
 	
 	Chunk(glm::ivec2 chunkPos, World* owningWorld);
 	Chunk(Chunk& other);
@@ -41,28 +76,42 @@ public:
 #pragma region Job Thread
 
 	void SetData(glm::ivec3 blockPos, uint8_t blockType);
+	// Replaces every block from blocks[x * CHUNK_HEIGHT * CHUNK_WIDTH + y * CHUNK_WIDTH + z], the save file layout
+	void SetBlocks(const uint8_t* blocks);
+	// Writes every block to out in the same layout
+	void GetBlocks(uint8_t* out);
 	void LoadData();
-	ChunkMesh* GenerateMesh(std::array<std::shared_ptr<Chunk>, 4> neighbors);
+	void GenerateData();
+	ChunkMesh* GenerateMesh(const std::array<std::shared_ptr<Chunk>, 4>& neighbors);
+	void RebuildMesh(const std::array<std::shared_ptr<Chunk>, 4>& neighbors, ChunkMesh* mesh, unsigned int sectionMask);
 	
 #pragma endregion
 
 #pragma region Main Thread Only
 	void GLLoad();
 	void GLUnload();
-	void RenderMesh(Shader* shader);
+	void RenderMesh(IRenderBackend* renderBackend);
 
 #pragma endregion
 
-	unsigned int GetDataAtPosition(glm::vec3 pos);
+	unsigned int GetDataAtPosition(glm::ivec3 pos);
+	const uint8_t* GetSectionData(unsigned int section);
+
+	static unsigned int SectionIndex(unsigned int x, unsigned int y, unsigned int z)
+	{
+		return x * CHUNK_SECTION_HEIGHT * CHUNK_WIDTH + (y % CHUNK_SECTION_HEIGHT) * CHUNK_WIDTH + z;
+	}
+	static const std::shared_ptr<ChunkSection>& GetEmptySection();
 
 private:
-	glm::ivec3 AbsBlockPosToRelPos(glm::ivec3 blockPos);
-	uint8_t GetNeighborBlockAtPos(glm::ivec3 pos, uint8_t* neighborData);
 	unsigned int PositionToIndex(unsigned int posX, unsigned int posY, unsigned int posZ);
 	unsigned int PositionToIndex(glm::ivec3 pos);
 	glm::vec3 IndexToPosition(unsigned int index);
-	bool BlockInChunkBounds(glm::ivec3 pos);
-	void AddFaceToMesh(glm::ivec3 blockPos, FaceDirection direction, ChunkMesh* mesh);
+	void BuildMeshSection(const std::array<std::shared_ptr<Chunk>, 4>& neighbors, ChunkMesh* mesh, unsigned int section);
+	void AddFaceToMesh(glm::ivec3 blockPos, uint8_t block, FaceDirection direction, ChunkMesh* mesh);
+	ChunkSection* GetWritableSection(unsigned int section);
 	void BufferMesh();
+	void ReleaseMesh();
+	void SetUploadedBytes(size_t bytes);
 };
 
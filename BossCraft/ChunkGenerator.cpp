@@ -0,0 +1,55 @@
+#include "ChunkGenerator.h"
+
+#include "GenerationStages.h"
+#include "HeightmapCache.h"
+#include "PendingBlockWrites.h"
+#include "Profiler.h"
+#include "TerrainNoise.h"
+
+ChunkGenerator::ChunkGenerator(TerrainNoise* noise, HeightmapCache* heightmapCache, PendingBlockWrites* pendingWrites)
+	: _noise(noise), _heightmapCache(heightmapCache), _pendingWrites(pendingWrites)
+{
+	AddDefaultStages();
+}
+
+void ChunkGenerator::AddStage(IGenerationStage* stage)
+{
+	Metrics::Histogram& timeUs = Metrics::GetHistogram(std::string("world.gen.") + stage->GetName() + "Us");
+	_stages.emplace_back(Stage{ std::unique_ptr<IGenerationStage>(stage), &timeUs });
+}
+
+void ChunkGenerator::ClearStages()
+{
+	_stages.clear();
+}
+
+void ChunkGenerator::AddDefaultStages()
+{
+	AddStage(new TerrainStage());
+	AddStage(new CaveStage());
+	AddStage(new SurfaceStage());
+	AddStage(new TreeStage());
+}
+
+void ChunkGenerator::Generate(glm::ivec2 chunkPos, uint8_t* blocks)
+{
+	GenerationContext context;
+	context.chunkPos = chunkPos;
+	context.seed = _noise->GetSeed();
+	context.blocks = blocks;
+	context.heightmapCache = _heightmapCache;
+	_heightmapCache->GetChunkHeights(chunkPos, context.heights);
+
+	for (Stage& stage : _stages)
+	{
+		PROFILE_SCOPE(stage.stage->GetName());
+		uint64_t start = Profiler::NowNs();
+		stage.stage->Generate(context);
+		stage.timeUs->Record((Profiler::NowNs() - start) / 1000);
+	}
+
+	for (auto& writes : context.outgoing)
+	{
+		_pendingWrites->Push(writes.first, std::move(writes.second));
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "IGenerationStage.h"
+#include "Metrics.h"
+
+class HeightmapCache;
+class PendingBlockWrites;
+class TerrainNoise;
+
+/**
+ * Runs the generation stages over a chunk's blocks. The default pipeline is terrain -> caves -> surface -> trees;
+ * stages can be added or replaced before the first chunk is generated.
+ */
+class ChunkGenerator
+{
+private:
+	struct Stage
+	{
+		std::unique_ptr<IGenerationStage> stage;
+		Metrics::Histogram* timeUs;
+	};
+
+	TerrainNoise* _noise;
+	HeightmapCache* _heightmapCache;
+	PendingBlockWrites* _pendingWrites;
+	std::vector<Stage> _stages;
+
+public:
+	ChunkGenerator(TerrainNoise* noise, HeightmapCache* heightmapCache, PendingBlockWrites* pendingWrites);
+
+	void AddStage(IGenerationStage* stage);
+	void ClearStages();
+	void AddDefaultStages();
+
+	// Job thread. Overwrites all CHUNK_VOLUME blocks; writes stages made into other chunks go to the pending writes.
+	void Generate(glm::ivec2 chunkPos, uint8_t* blocks);
+};
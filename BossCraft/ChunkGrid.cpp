@@ -0,0 +1,77 @@
+#include "ChunkGrid.h"
+
+#include "Chunk.h"
+
+ChunkGrid::ChunkGrid()
+{
+	_size = 1;
+	_usedCount = 0;
+	_slots.resize(1);
+}
+
+void ChunkGrid::Resize(unsigned int size)
+{
+	std::vector<Slot> old;
+	old.swap(_slots);
+
+	_size = size > 0 ? static_cast<int>(size) : 1;
+	_slots.resize(static_cast<size_t>(_size) * _size);
+	for (Slot& slot : old)
+	{
+		if (slot.used)
+		{
+			_slots[SlotIndex(slot.pos)] = std::move(slot);
+		}
+	}
+}
+
+unsigned int ChunkGrid::GetSize()
+{
+	return static_cast<unsigned int>(_size);
+}
+
+size_t ChunkGrid::GetUsedCount()
+{
+	return _usedCount;
+}
+
+bool ChunkGrid::Reserve(glm::ivec2 pos)
+{
+	Slot& slot = _slots[SlotIndex(pos)];
+	if (slot.used)
+	{
+		return slot.pos == pos;
+	}
+
+	slot.pos = pos;
+	slot.used = true;
+	slot.chunk = NULL;
+	_usedCount++;
+	return true;
+}
+
+bool ChunkGrid::Set(glm::ivec2 pos, std::shared_ptr<Chunk> chunk)
+{
+	Slot* slot = Find(pos);
+	if (slot == NULL)
+	{
+		return false;
+	}
+	slot->chunk = chunk;
+	return true;
+}
+
+std::shared_ptr<Chunk> ChunkGrid::Erase(glm::ivec2 pos)
+{
+	Slot* slot = Find(pos);
+	if (slot == NULL)
+	{
+		return NULL;
+	}
+
+	std::shared_ptr<Chunk> chunk = slot->chunk;
+	slot->chunk = NULL;
+	slot->used = false;
+	_usedCount--;
+	return chunk;
+}
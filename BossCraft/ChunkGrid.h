@@ -0,0 +1,71 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+class Chunk;
+
+/**
+ * The chunks around the player in a fixed size toroidal grid: chunk (x, z) lives in slot (x mod size, z mod size), so a
+ * lookup is two modulos and a compare, with no hashing. The window only ever covers size x size chunks, so two chunks
+ * in it never share a slot; moving it only touches the slots that scroll out.
+ */
+class ChunkGrid
+{
+public:
+	struct Slot
+	{
+		glm::ivec2 pos;
+		// The slot belongs to pos, either waiting for it to load (chunk is NULL) or holding it
+		bool used;
+		std::shared_ptr<Chunk> chunk;
+	};
+
+private:
+	int _size;
+	size_t _usedCount;
+	std::vector<Slot> _slots;
+
+public:
+	ChunkGrid();
+
+	// Makes the grid size x size, keeping the slots in use; they must all fit in a size x size window
+	void Resize(unsigned int size);
+	unsigned int GetSize();
+	size_t GetUsedCount();
+
+	// The slot owned by pos, or NULL if pos isn't in the grid
+	Slot* Find(glm::ivec2 pos)
+	{
+		Slot& slot = _slots[SlotIndex(pos)];
+		return slot.used && slot.pos == pos ? &slot : NULL;
+	}
+
+	// The loaded chunk at pos, NULL if it isn't in the grid or hasn't loaded yet
+	std::shared_ptr<Chunk> Get(glm::ivec2 pos)
+	{
+		Slot* slot = Find(pos);
+		return slot != NULL ? slot->chunk : NULL;
+	}
+
+	bool Contains(glm::ivec2 pos)
+	{
+		return Find(pos) != NULL;
+	}
+
+	// Claims the slot for pos while it loads; false if a chunk still in the grid holds it
+	bool Reserve(glm::ivec2 pos);
+	// Fills a slot claimed by Reserve; false if pos no longer owns it
+	bool Set(glm::ivec2 pos, std::shared_ptr<Chunk> chunk);
+	// Frees pos's slot and returns the chunk that was in it
+	std::shared_ptr<Chunk> Erase(glm::ivec2 pos);
+
+private:
+	size_t SlotIndex(glm::ivec2 pos)
+	{
+		int x = ((pos.x % _size) + _size) % _size;
+		int z = ((pos.y % _size) + _size) % _size;
+		return static_cast<size_t>(x) * _size + z;
+	}
+};
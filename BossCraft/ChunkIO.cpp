@@ -0,0 +1,213 @@
+#include "ChunkIO.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include "Chunk.h"
+#include "ChunkResources.h"
+#include "IoUringChunkIOBackend.h"
+#include "MemoryBudget.h"
+#include "Metrics.h"
+#include "Profiler.h"
+#include "ThreadPoolChunkIOBackend.h"
+
+IChunkIOBackend* ChunkIO::_backend = nullptr;
+std::vector<ChunkIORequest> ChunkIO::_pending;
+std::unordered_map<std::string, ChunkIO::PendingSave> ChunkIO::_saves;
+std::mutex ChunkIO::_pendingMutex;
+
+void ChunkIO::Init()
+{
+#ifdef __linux__
+	_backend = IoUringChunkIOBackend::Create(256);
+#endif
+	if (_backend == nullptr)
+	{
+		_backend = new ThreadPoolChunkIOBackend(2);
+	}
+	std::cout << "Chunk IO backend: " << _backend->GetName() << std::endl;
+}
+
+void ChunkIO::Shutdown()
+{
+	Drain();
+	delete _backend;
+	_backend = nullptr;
+}
+
+const char* ChunkIO::GetBackendName()
+{
+	return _backend->GetName();
+}
+
+void ChunkIO::QueueLoad(std::shared_ptr<Chunk> chunk, const std::function<void(std::shared_ptr<Chunk>, bool)>& onComplete)
+{
+	assert(chunk != NULL);
+
+	std::shared_ptr<uint8_t> buffer = AllocateBuffer();
+	std::function<void(std::shared_ptr<Chunk>, bool)> fill = [buffer, onComplete](std::shared_ptr<Chunk> loaded, bool success)
+		{
+			if (success)
+			{
+				loaded->SetBlocks(buffer.get());
+			}
+			onComplete(loaded, success);
+		};
+	ChunkIORequest request{ ChunkIOOp::Load, chunk, ChunkResources::GetChunkPath(chunk->_chunkPos), buffer, fill };
+	std::lock_guard<std::mutex> lock(_pendingMutex);
+	_pending.emplace_back(std::move(request));
+}
+
+void ChunkIO::QueueSave(std::shared_ptr<Chunk> chunk)
+{
+	assert(chunk != NULL);
+
+	// Flattened now; the backend only sees bytes
+	std::shared_ptr<uint8_t> buffer = AllocateBuffer();
+	chunk->GetBlocks(buffer.get());
+	std::string path = ChunkResources::GetChunkPath(chunk->_chunkPos);
+
+	std::lock_guard<std::mutex> lock(_pendingMutex);
+	auto save = _saves.find(path);
+	if (save != _saves.end() && save->second.writing)
+	{
+		// Two writes of one file could land in either order
+		save->second.buffer = buffer;
+		save->second.rewrite = true;
+		return;
+	}
+	// Also gives a save that failed for good another try
+	_saves[path] = PendingSave{ buffer, true, false, 0 };
+	_pending.emplace_back(MakeSaveRequest(path, buffer));
+}
+
+bool ChunkIO::LoadNow(glm::ivec2 chunkPos, std::array<uint8_t, CHUNK_VOLUME>* blocks)
+{
+	{
+		std::lock_guard<std::mutex> lock(_pendingMutex);
+		auto save = _saves.find(ChunkResources::GetChunkPath(chunkPos));
+		if (save != _saves.end())
+		{
+			memcpy(blocks->data(), save->second.buffer.get(), CHUNK_VOLUME);
+			return true;
+		}
+	}
+	// Every save of the file has been written
+	return ChunkResources::LoadChunk(chunkPos, blocks);
+}
+
+ChunkIORequest ChunkIO::MakeSaveRequest(const std::string& path, std::shared_ptr<uint8_t> buffer)
+{
+	return ChunkIORequest{ ChunkIOOp::Save, NULL, path, buffer, [path](std::shared_ptr<Chunk>, bool success)
+		{
+			OnSaveComplete(path, success);
+		} };
+}
+
+void ChunkIO::OnSaveComplete(const std::string& path, bool success)
+{
+	static Metrics::Counter& saveFailures = Metrics::GetCounter("chunkIO.saveFailures");
+
+	std::lock_guard<std::mutex> lock(_pendingMutex);
+	auto save = _saves.find(path);
+	PendingSave& pending = save->second;
+	if (success)
+	{
+		pending.failures = 0;
+		if (!pending.rewrite)
+		{
+			_saves.erase(save);
+			return;
+		}
+	}
+	else
+	{
+		saveFailures.Add();
+		// A newer save gets its own attempts
+		if (!pending.rewrite && ++pending.failures > _maxSaveRetries)
+		{
+			std::cerr << "Failed to write " << path << "; keeping its blocks in memory" << std::endl;
+			pending.writing = false;
+			return;
+		}
+	}
+	// Goes out with the next flush; the file may be half written, so a failed save is written again whole
+	pending.rewrite = false;
+	_pending.emplace_back(MakeSaveRequest(path, pending.buffer));
+}
+
+void ChunkIO::Drain()
+{
+	PROFILE_FUNCTION();
+	while (true)
+	{
+		Flush();
+		{
+			std::lock_guard<std::mutex> lock(_pendingMutex);
+			bool writing = std::any_of(_saves.begin(), _saves.end(),
+				[](const std::pair<const std::string, PendingSave>& save) { return save.second.writing; });
+			if (!writing && _pending.empty())
+			{
+				return;
+			}
+		}
+		std::this_thread::yield();
+	}
+}
+
+std::shared_ptr<uint8_t> ChunkIO::AllocateBuffer()
+{
+	MemoryBudget::Add(MemoryCategory::QueuedJobs, CHUNK_VOLUME);
+	return std::shared_ptr<uint8_t>(new uint8_t[CHUNK_VOLUME], [](uint8_t* buffer)
+		{
+			delete[] buffer;
+			MemoryBudget::Add(MemoryCategory::QueuedJobs, -static_cast<int64_t>(CHUNK_VOLUME));
+		});
+}
+
+void ChunkIO::Flush()
+{
+	PROFILE_FUNCTION();
+	static Metrics::Counter& loadsFromPendingSaves = Metrics::GetCounter("chunkIO.loadsFromPendingSaves");
+
+	std::vector<ChunkIORequest> batch;
+	std::vector<ChunkIORequest> served;
+	{
+		std::lock_guard<std::mutex> lock(_pendingMutex);
+		if (_pending.empty())
+		{
+			return;
+		}
+		batch.swap(_pending);
+
+		// The file may be half written; the save's blocks are what it will hold
+		auto end = std::remove_if(batch.begin(), batch.end(), [&served](ChunkIORequest& request)
+			{
+				if (request.op != ChunkIOOp::Load)
+				{
+					return false;
+				}
+				auto save = _saves.find(request.path);
+				if (save == _saves.end())
+				{
+					return false;
+				}
+				memcpy(request.buffer.get(), save->second.buffer.get(), CHUNK_VOLUME);
+				served.emplace_back(std::move(request));
+				return true;
+			});
+		batch.erase(end, batch.end());
+	}
+
+	for (ChunkIORequest& request : served)
+	{
+		loadsFromPendingSaves.Add();
+		request.onComplete(request.chunk, true);
+	}
+	if (!batch.empty())
+	{
+		_backend->Submit(batch);
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <array>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "Chunk.h"
+#include "IChunkIOBackend.h"
+
+/**
+ * Asynchronous chunk load/save. Requests are queued during the frame and handed to the backend in one batch by Flush(),
+ * so no JobSystem worker ever blocks on the disk.
+ *
+ * Backends don't order requests, so ChunkIO does for each file: until a save is on disk, loads of the file are served
+ * from its blocks, and a newer save waits for the write before it to finish. A write that fails is retried a few times;
+ * after that the blocks stay in memory, still served to loads, until the chunk is saved again.
+ */
+class ChunkIO
+{
+private:
+	struct PendingSave
+	{
+		// Newest blocks saved for the file
+		std::shared_ptr<uint8_t> buffer;
+		// A write of the file is queued or in flight; false once writing it has failed too often
+		bool writing;
+		// Saved again while a write of the file was queued or in flight; written once that one completes
+		bool rewrite;
+		// Failed writes in a row
+		unsigned int failures;
+	};
+
+	static const unsigned int _maxSaveRetries = 3;
+
+	static IChunkIOBackend* _backend;
+	static std::vector<ChunkIORequest> _pending;
+	// Files with a save that isn't on disk yet
+	static std::unordered_map<std::string, PendingSave> _saves;
+	// Guards _pending and _saves
+	static std::mutex _pendingMutex;
+
+public:
+	// Picks io_uring where the kernel allows it, otherwise a thread pool of blocking readers. Call after ChunkResources::Init.
+	static void Init();
+
+	// Writes every save still pending, then stops the backend once its requests complete. Nothing may queue loads or
+	// saves after this.
+	static void Shutdown();
+
+	static const char* GetBackendName();
+
+	static void QueueLoad(std::shared_ptr<Chunk> chunk, const std::function<void(std::shared_ptr<Chunk>, bool)>& onComplete);
+	static void QueueSave(std::shared_ptr<Chunk> chunk);
+	// Loads on the calling thread, from a save that isn't on disk yet if there is one; false if the chunk was never saved
+	static bool LoadNow(glm::ivec2 chunkPos, std::array<uint8_t, CHUNK_VOLUME>* blocks);
+
+	// Submits everything queued since the last flush
+	static void Flush();
+	// Flushes until every save queued so far is on disk or has given up; blocks the calling thread
+	static void Drain();
+
+private:
+	static std::shared_ptr<uint8_t> AllocateBuffer();
+	static ChunkIORequest MakeSaveRequest(const std::string& path, std::shared_ptr<uint8_t> buffer);
+	static void OnSaveComplete(const std::string& path, bool success);
+};
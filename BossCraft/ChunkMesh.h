@@ -1,4 +1,27 @@
 #pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "Chunk.h"
+#include "MemoryBudget.h"
+
+// Meshes are built per block section; editing a block only rebuilds the sections whose faces it touches
+const unsigned int MESH_SECTION_HEIGHT = CHUNK_SECTION_HEIGHT;
+const unsigned int MESH_SECTION_COUNT = CHUNK_SECTION_COUNT;
+const unsigned int MESH_ALL_SECTIONS = (1u << MESH_SECTION_COUNT) - 1;
+
+const int FACE_INDICES[] = { 1, 0, 3, 1, 3, 2 };
+
+// What a chunk keeps of its mesh once it's on the GPU
+enum class MeshRetention
+{
+	// Nothing; an edit remeshes every section of the chunk
+	None,
+	// The vertex data trimmed to size, without indices, so edits only remesh the sections they touch and the mesh can
+	// be uploaded again without rebuilding it
+	Compact
+};
 
 struct ChunkMesh
 {
@@ -7,37 +30,99 @@ struct ChunkMesh
 		vertexCount = 0;
 		dataIndex = 0;
 		indicesIndex = 0;
-
-		dataBuffer = new uint32_t[(CHUNK_VOLUME) * 4 * 6];
-		indexBuffer = new uint16_t[(CHUNK_VOLUME) * 6 * 6];
+		accountedBytes = 0;
+		sectionStart.fill(0);
 	}
 
+	// Indices aren't copied, they only depend on the face count and are rebuilt by UpdateIndices
 	ChunkMesh(ChunkMesh& other)
 	{
-		vertexCount = other.vertexCount;
-		dataIndex = other.dataIndex;
-		indicesIndex = other.indicesIndex;
-
-		dataBuffer = new uint32_t[(CHUNK_VOLUME) * 4 * 6];
-		memcpy(dataBuffer, other.dataBuffer, CHUNK_VOLUME * 4 * 6 * sizeof(uint32_t));
-		indexBuffer = new uint16_t[(CHUNK_VOLUME) * 6 * 6];
-		memcpy(indexBuffer, other.indexBuffer, CHUNK_VOLUME * 6 * 6 * sizeof(uint16_t));
+		vertexCount = 0;
+		dataIndex = 0;
+		indicesIndex = 0;
+		accountedBytes = 0;
+		dataBuffer = other.dataBuffer;
+		sectionStart = other.sectionStart;
 	}
 
 	~ChunkMesh()
 	{
-		delete[] dataBuffer;
-		delete[] indexBuffer;
+		MemoryBudget::Add(MemoryCategory::CpuMeshes, -static_cast<int64_t>(accountedBytes));
 	}
-	
+
 	unsigned int vertexCount;
 	unsigned int dataIndex;
 	unsigned int indicesIndex;
-	uint32_t* dataBuffer;
-	uint16_t* indexBuffer;
+	// Packed vertices, four per face, ordered by section
+	std::vector<uint32_t> dataBuffer;
+	std::vector<uint16_t> indexBuffer;
+	// Where each section's vertices start in dataBuffer; the last entry is the end of the data
+	std::array<unsigned int, MESH_SECTION_COUNT + 1> sectionStart;
+	// What MemoryBudget was last told the vectors hold
+	size_t accountedBytes;
+
+	void Clear()
+	{
+		dataBuffer.clear();
+		sectionStart.fill(0);
+	}
+
+	// Sets the counts from dataBuffer and makes sure indexBuffer covers every face
+	void UpdateIndices()
+	{
+		size_t faces = dataBuffer.size() / 4;
+		size_t built = indexBuffer.size() / 6;
+		if (built < faces)
+		{
+			// Every face is a quad, so indices never change once written
+			indexBuffer.resize(faces * 6);
+			for (size_t face = built; face < faces; face++)
+			{
+				for (int i = 0; i < 6; i++)
+				{
+					indexBuffer[face * 6 + i] = static_cast<uint16_t>(face * 4 + FACE_INDICES[i]);
+				}
+			}
+		}
+
+		vertexCount = static_cast<unsigned int>(dataBuffer.size());
+		dataIndex = static_cast<unsigned int>(dataBuffer.size());
+		indicesIndex = static_cast<unsigned int>(faces * 6);
+		UpdateAccountedBytes();
+	}
+
+	// Frees the indices and the spare capacity of dataBuffer; UpdateIndices brings the indices back
+	void Compact()
+	{
+		dataBuffer.shrink_to_fit();
+		std::vector<uint16_t>().swap(indexBuffer);
+		UpdateAccountedBytes();
+	}
+
+	void UpdateAccountedBytes()
+	{
+		size_t bytes = dataBuffer.capacity() * sizeof(uint32_t) + indexBuffer.capacity() * sizeof(uint16_t);
+		MemoryBudget::Add(MemoryCategory::CpuMeshes, static_cast<int64_t>(bytes) - static_cast<int64_t>(accountedBytes));
+		accountedBytes = bytes;
+	}
+
+	// Sections whose faces can change when the block at height y does: its own, and the one it borders if any
+	static unsigned int SectionsTouchingBlock(unsigned int y)
+	{
+		unsigned int section = y / MESH_SECTION_HEIGHT;
+		unsigned int mask = 1u << section;
+		if (y % MESH_SECTION_HEIGHT == 0 && section > 0)
+		{
+			mask |= 1u << (section - 1);
+		}
+		if (y % MESH_SECTION_HEIGHT == MESH_SECTION_HEIGHT - 1 && section < MESH_SECTION_COUNT - 1)
+		{
+			mask |= 1u << (section + 1);
+		}
+		return mask;
+	}
 };
 
-const int FACE_INDICES[] = { 1, 0, 3, 1, 3, 2 };
 const int UNIQUE_INDICES[] = { 1, 0, 5, 2 };
 const int CUBE_INDICES[] = {
 	1, 0, 3, 1, 3, 2, // north (-z)
@@ -0,0 +1,97 @@
+#include "ChunkPool.h"
+
+#include <cassert>
+#include <new>
+
+#include "Metrics.h"
+
+ChunkPool::Storage::Storage()
+{
+	slotSize = 0;
+	live = 0;
+}
+
+ChunkPool::Storage::~Storage()
+{
+	for (void* slab : slabs)
+	{
+		::operator delete(slab);
+	}
+}
+
+void* ChunkPool::Storage::Take(size_t size)
+{
+	static Metrics::Counter& slabsAllocated = Metrics::GetCounter("world.chunkPool.slabsAllocated");
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (slotSize == 0)
+	{
+		slotSize = size;
+	}
+	assert(size == slotSize);
+	if (free.empty())
+	{
+		unsigned char* slab = static_cast<unsigned char*>(::operator new(slotSize * SlabSlots));
+		slabs.push_back(slab);
+		for (size_t i = SlabSlots; i > 0; i--)
+		{
+			free.push_back(slab + (i - 1) * slotSize);
+		}
+		slabsAllocated.Add();
+	}
+
+	void* slot = free.back();
+	free.pop_back();
+	live++;
+	return slot;
+}
+
+void ChunkPool::Storage::Return(void* slot)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	free.push_back(slot);
+	live--;
+}
+
+ChunkPool::ChunkPool() : _chunks(std::make_shared<Storage>()), _sections(std::make_shared<Storage>())
+{
+}
+
+std::shared_ptr<Chunk> ChunkPool::Acquire(glm::ivec2 chunkPos, World* world)
+{
+	return std::allocate_shared<Chunk>(Allocator<Chunk>(_chunks), chunkPos, world);
+}
+
+std::shared_ptr<Chunk> ChunkPool::Acquire(Chunk& other)
+{
+	return std::allocate_shared<Chunk>(Allocator<Chunk>(_chunks), other);
+}
+
+std::shared_ptr<ChunkSection> ChunkPool::AcquireSection()
+{
+	return std::allocate_shared<ChunkSection>(Allocator<ChunkSection>(_sections));
+}
+
+size_t ChunkPool::GetSlotCount()
+{
+	std::lock_guard<std::mutex> lock(_chunks->mutex);
+	return _chunks->slabs.size() * SlabSlots;
+}
+
+size_t ChunkPool::GetLiveCount()
+{
+	std::lock_guard<std::mutex> lock(_chunks->mutex);
+	return _chunks->live;
+}
+
+size_t ChunkPool::GetSectionSlotCount()
+{
+	std::lock_guard<std::mutex> lock(_sections->mutex);
+	return _sections->slabs.size() * SlabSlots;
+}
+
+size_t ChunkPool::GetLiveSectionCount()
+{
+	std::lock_guard<std::mutex> lock(_sections->mutex);
+	return _sections->live;
+}
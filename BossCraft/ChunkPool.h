@@ -0,0 +1,111 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "Chunk.h"
+
+class World;
+
+/**
+ * Recycles chunks and their block sections. Every load makes a chunk and its sections, every edit a chunk and a
+ * section, and while streaming they would otherwise go back and forth to the heap all the time. They come out of
+ * std::allocate_shared with a pool allocator, so each slot holds the object and its shared_ptr control block together,
+ * and whichever job, save or frame drops one last puts the slot back on a free list, from any thread.
+ *
+ * Storage grows a slab at a time and is never given back while the pool or anything from it is alive.
+ */
+class ChunkPool
+{
+public:
+	static const size_t SlabSlots = 32;
+
+private:
+	struct Storage
+	{
+		std::mutex mutex;
+		// Set by the first Take; allocate_shared only ever asks for its one control block type
+		size_t slotSize;
+		std::vector<void*> slabs;
+		std::vector<void*> free;
+		size_t live;
+
+		Storage();
+		~Storage();
+
+		void* Take(size_t size);
+		void Return(void* slot);
+	};
+
+	// Holds the storage, so anything still out in jobs can be returned after the pool is gone
+	template <typename T>
+	struct Allocator
+	{
+		typedef T value_type;
+
+		std::shared_ptr<Storage> storage;
+
+		explicit Allocator(std::shared_ptr<Storage> storage) : storage(std::move(storage)) {}
+		template <typename U>
+		Allocator(const Allocator<U>& other) : storage(other.storage) {}
+
+		T* allocate(size_t count)
+		{
+			// Slots are a whole number of items apart, so each is as aligned as its slab
+			static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "Pooled types need an aligned operator new");
+			return count == 1 ? static_cast<T*>(storage->Take(sizeof(T))) : std::allocator<T>().allocate(count);
+		}
+
+		void deallocate(T* item, size_t count)
+		{
+			if (count == 1)
+			{
+				storage->Return(item);
+			}
+			else
+			{
+				std::allocator<T>().deallocate(item, count);
+			}
+		}
+
+		// Default-initializes like new T, so sections aren't zeroed only to be overwritten
+		template <typename U>
+		void construct(U* item)
+		{
+			::new (static_cast<void*>(item)) U;
+		}
+
+		template <typename U, typename... Args>
+		void construct(U* item, Args&&... args)
+		{
+			::new (static_cast<void*>(item)) U(std::forward<Args>(args)...);
+		}
+
+		template <typename U>
+		bool operator==(const Allocator<U>& other) const { return storage == other.storage; }
+		template <typename U>
+		bool operator!=(const Allocator<U>& other) const { return storage != other.storage; }
+	};
+
+	std::shared_ptr<Storage> _chunks;
+	std::shared_ptr<Storage> _sections;
+
+public:
+	ChunkPool();
+
+	// A new chunk waiting for its blocks
+	std::shared_ptr<Chunk> Acquire(glm::ivec2 chunkPos, World* world);
+	// A copy of other, sharing its sections
+	std::shared_ptr<Chunk> Acquire(Chunk& other);
+	// Uninitialized blocks
+	std::shared_ptr<ChunkSection> AcquireSection();
+
+	size_t GetSlotCount();
+	size_t GetLiveCount();
+	size_t GetSectionSlotCount();
+	size_t GetLiveSectionCount();
+};
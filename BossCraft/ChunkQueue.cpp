@@ -0,0 +1,64 @@
+#include "ChunkQueue.h"
+
+#include <algorithm>
+
+ChunkQueue::ChunkQueue()
+{
+	_center = glm::ivec2(0, 0);
+	_stale = false;
+}
+
+void ChunkQueue::SetCenter(glm::ivec2 center)
+{
+	if (center != _center)
+	{
+		_center = center;
+		_stale = true;
+	}
+}
+
+void ChunkQueue::Push(glm::ivec2 pos)
+{
+	_heap.push_back(pos);
+	if (!_stale)
+	{
+		std::push_heap(_heap.begin(), _heap.end(), Farther{ _center });
+	}
+}
+
+glm::ivec2 ChunkQueue::Top()
+{
+	Rebuild();
+	return _heap.front();
+}
+
+void ChunkQueue::Pop()
+{
+	Rebuild();
+	std::pop_heap(_heap.begin(), _heap.end(), Farther{ _center });
+	_heap.pop_back();
+}
+
+bool ChunkQueue::Empty()
+{
+	return _heap.empty();
+}
+
+size_t ChunkQueue::Size()
+{
+	return _heap.size();
+}
+
+int ChunkQueue::DistanceSquared(glm::ivec2 pos)
+{
+	return Farther::DistanceSquared(pos - _center);
+}
+
+void ChunkQueue::Rebuild()
+{
+	if (_stale)
+	{
+		std::make_heap(_heap.begin(), _heap.end(), Farther{ _center });
+		_stale = false;
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+/**
+ * Chunk positions waiting for work, nearest to the center first, so the ground under the player loads and meshes
+ * before the edge of the window. Moving the center only marks the order stale; the heap is rebuilt the next time
+ * something is taken out, so crossing several chunk borders between two frames costs a single rebuild.
+ */
+class ChunkQueue
+{
+private:
+	// Heap order: the root is the position nearest the center
+	struct Farther
+	{
+		glm::ivec2 center;
+
+		static int DistanceSquared(glm::ivec2 offset)
+		{
+			return offset.x * offset.x + offset.y * offset.y;
+		}
+
+		bool operator()(glm::ivec2 a, glm::ivec2 b) const
+		{
+			return DistanceSquared(a - center) > DistanceSquared(b - center);
+		}
+	};
+
+	std::vector<glm::ivec2> _heap;
+	glm::ivec2 _center;
+	bool _stale;
+
+public:
+	ChunkQueue();
+
+	void SetCenter(glm::ivec2 center);
+
+	void Push(glm::ivec2 pos);
+	// Nearest position; the queue must not be empty
+	glm::ivec2 Top();
+	void Pop();
+
+	bool Empty();
+	size_t Size();
+
+	// Squared distance from the center, the order positions come out in
+	int DistanceSquared(glm::ivec2 pos);
+
+private:
+	void Rebuild();
+};
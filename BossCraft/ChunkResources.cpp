@@ -3,55 +3,38 @@
 #include <fstream>
 #include <iostream>
 #include <sstream>
-#include <Windows.h>
 
 #include "Chunk.h"
+#include "Platform.h"
 
 std::string ChunkResources::_saveFolder;
 
 void ChunkResources::Init(std::string saveFolder)
 {
 	_saveFolder = saveFolder;
-	if (!CreateDirectoryA(saveFolder.c_str(), NULL))
+	if (!Platform::EnsureDirectory(saveFolder))
 	{
-		int err = GetLastError();
-		if (err == ERROR_PATH_NOT_FOUND)
-		{
-			std::cout << "CHUNK-SAVE ERROR: " << saveFolder << "not found!" << std::endl;
-			return;
-		}
+		std::cout << "CHUNK-SAVE ERROR: " << saveFolder << " could not be created!" << std::endl;
 	}
 }
 
-void ChunkResources::SaveChunk(std::shared_ptr<Chunk> chunk)
+std::string ChunkResources::GetChunkPath(glm::ivec2 chunkPos)
 {
-	assert(chunk != NULL);
-	
 	std::stringstream fileName;
-	fileName << "chunk" << chunk->_chunkPos[0] << "-" << chunk->_chunkPos[1];
-	{
-		std::ofstream outStream(_saveFolder + "/" + fileName.str(), std::ios::binary);
-		if (outStream.good())
-		{
-			outStream.write(reinterpret_cast<char*>(chunk->_data.data()), sizeof(char) * CHUNK_VOLUME);
-		}
-		
-	}
+	fileName << _saveFolder << "/chunk" << chunkPos[0] << "-" << chunkPos[1];
+	return fileName.str();
 }
 
 bool ChunkResources::LoadChunk(glm::ivec2 chunkPos, std::array<uint8_t, CHUNK_VOLUME>* data)
 {
-	std::stringstream fileName;
-	fileName << "chunk" << chunkPos[0] << "-" << chunkPos[1];
 	{
-		std::ifstream inStream(_saveFolder + "/" + fileName.str(), std::ios::binary);
+		std::ifstream inStream(GetChunkPath(chunkPos), std::ios::binary);
 
 		if (!inStream.good())
 		{
-			return NULL;
+			return false;
 		}
-		std::copy_n(std::istream_iterator<char>{inStream}, CHUNK_VOLUME, data->begin());
-		//inStream.read(reinterpret_cast<char*>(data), sizeof(char) * CHUNK_VOLUME);
-		return data;
+		inStream.read(reinterpret_cast<char*>(data->data()), sizeof(char) * CHUNK_VOLUME);
+		return inStream.gcount() == CHUNK_VOLUME;
 	}
 }
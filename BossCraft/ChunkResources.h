@@ -13,9 +13,10 @@ private:
 	
 public:
 	static void Init(std::string saveFolder);
-	
-	static void SaveChunk(std::shared_ptr<Chunk> chunk);
 
+	static std::string GetChunkPath(glm::ivec2 chunkPos);
+
+	// Blocking; saves go through ChunkIO
 	static bool LoadChunk(glm::ivec2 chunkPos, std::array<uint8_t, CHUNK_VOLUME>* data);
 };
 
@@ -39,7 +39,7 @@ public:
 		if (_tail != _head)
 		{
 			item = _data[_tail];
-			_data[_tail] = NULL;
+			_data[_tail] = T();
 			_tail = (_tail + 1) % capacity;
 			result = true;
 		}
@@ -51,4 +51,10 @@ public:
 	{
 		return _head == _tail;
 	}
+
+	size_t Size()
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		return (_head + capacity - _tail) % capacity;
+	}
 };
@@ -0,0 +1,172 @@
+#include "DensityField.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BOSSCRAFT_DENSITY_SSE2 1
+#include <emmintrin.h>
+#endif
+
+static_assert(CHUNK_WIDTH == 16, "SelectSlice packs one row into a single 16 byte vector");
+static_assert(DensityField::CellWidth == 4, "RowDensity fills one cell per 4 lane vector");
+
+void DensityField::Sample(FastNoiseLite& noise, glm::ivec2 chunkPos, unsigned int minY, unsigned int maxY, float yScale)
+{
+	if (maxY <= minY)
+	{
+		return;
+	}
+
+	unsigned int firstLayer = minY / CellHeight;
+	unsigned int lastLayer = (maxY - 1) / CellHeight + 1;
+	if (lastLayer > SamplesY - 1)
+	{
+		lastLayer = SamplesY - 1;
+	}
+
+	glm::ivec2 origin = chunkPos * static_cast<int>(CHUNK_WIDTH);
+	for (unsigned int sx = 0; sx < SamplesXZ; sx++)
+	{
+		for (unsigned int sy = firstLayer; sy <= lastLayer; sy++)
+		{
+			for (unsigned int sz = 0; sz < SamplesXZ; sz++)
+			{
+				_samples[sx][sy][sz] = noise.GetNoise(
+					static_cast<float>(origin.x + static_cast<int>(sx * CellWidth)),
+					sy * CellHeight * yScale,
+					static_cast<float>(origin.y + static_cast<int>(sz * CellWidth)));
+			}
+		}
+	}
+}
+
+namespace
+{
+	const unsigned int PlaneStride = DensityField::SamplesXZ;
+
+	// Lerp the two lattice planes either side of x once, so every row only lerps along y and z
+	void BuildPlane(const float* samplesX0, const float* samplesX1, float fx, unsigned int firstLayer, unsigned int lastLayer, float* plane)
+	{
+		for (unsigned int i = firstLayer * PlaneStride; i < (lastLayer + 1) * PlaneStride; i++)
+		{
+			plane[i] = samplesX0[i] + (samplesX1[i] - samplesX0[i]) * fx;
+		}
+	}
+
+#ifdef BOSSCRAFT_DENSITY_SSE2
+	// The CHUNK_WIDTH densities of row y as four vectors of one cell each
+	inline void RowDensity(const float* plane, unsigned int y, __m128* out)
+	{
+		unsigned int sy = y / DensityField::CellHeight;
+		__m128 fy = _mm_set1_ps((y % DensityField::CellHeight) * (1.0f / DensityField::CellHeight));
+
+		// Lattice points 0-3 along z in one vector, point 4 on its own
+		const float* below = plane + sy * PlaneStride;
+		const float* above = below + PlaneStride;
+		__m128 lower = _mm_loadu_ps(below);
+		__m128 column = _mm_add_ps(lower, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(above), lower), fy));
+		float last = below[4] + (above[4] - below[4]) * _mm_cvtss_f32(fy);
+
+		// Points 1-4, so next - column is the per cell slope
+		__m128 rotated = _mm_move_ss(column, _mm_set_ss(last));
+		__m128 next = _mm_shuffle_ps(rotated, rotated, _MM_SHUFFLE(0, 3, 2, 1));
+		__m128 delta = _mm_sub_ps(next, column);
+
+		const __m128 steps = _mm_setr_ps(0.0f, 0.25f, 0.5f, 0.75f);
+		out[0] = _mm_add_ps(_mm_shuffle_ps(column, column, _MM_SHUFFLE(0, 0, 0, 0)), _mm_mul_ps(_mm_shuffle_ps(delta, delta, _MM_SHUFFLE(0, 0, 0, 0)), steps));
+		out[1] = _mm_add_ps(_mm_shuffle_ps(column, column, _MM_SHUFFLE(1, 1, 1, 1)), _mm_mul_ps(_mm_shuffle_ps(delta, delta, _MM_SHUFFLE(1, 1, 1, 1)), steps));
+		out[2] = _mm_add_ps(_mm_shuffle_ps(column, column, _MM_SHUFFLE(2, 2, 2, 2)), _mm_mul_ps(_mm_shuffle_ps(delta, delta, _MM_SHUFFLE(2, 2, 2, 2)), steps));
+		out[3] = _mm_add_ps(_mm_shuffle_ps(column, column, _MM_SHUFFLE(3, 3, 3, 3)), _mm_mul_ps(_mm_shuffle_ps(delta, delta, _MM_SHUFFLE(3, 3, 3, 3)), steps));
+	}
+#else
+	inline void RowDensity(const float* plane, unsigned int y, float* out)
+	{
+		unsigned int sy = y / DensityField::CellHeight;
+		float fy = (y % DensityField::CellHeight) * (1.0f / DensityField::CellHeight);
+		const float* below = plane + sy * PlaneStride;
+		const float* above = below + PlaneStride;
+
+		float column[DensityField::SamplesXZ];
+		for (unsigned int sz = 0; sz < DensityField::SamplesXZ; sz++)
+		{
+			column[sz] = below[sz] + (above[sz] - below[sz]) * fy;
+		}
+		for (unsigned int z = 0; z < CHUNK_WIDTH; z++)
+		{
+			unsigned int cell = z / DensityField::CellWidth;
+			out[z] = column[cell] + (column[cell + 1] - column[cell]) * ((z % DensityField::CellWidth) * (1.0f / DensityField::CellWidth));
+		}
+	}
+#endif
+}
+
+void DensityField::InterpolateSlice(unsigned int x, unsigned int minY, unsigned int maxY, float* out) const
+{
+	if (maxY <= minY)
+	{
+		return;
+	}
+
+	float plane[SamplesY * SamplesXZ];
+	unsigned int sx = x / CellWidth;
+	BuildPlane(&_samples[sx][0][0], &_samples[sx + 1][0][0], (x % CellWidth) * (1.0f / CellWidth), minY / CellHeight, (maxY - 1) / CellHeight + 1, plane);
+
+	for (unsigned int y = minY; y < maxY; y++)
+	{
+		float* row = out + (y - minY) * CHUNK_WIDTH;
+#ifdef BOSSCRAFT_DENSITY_SSE2
+		__m128 density[4];
+		RowDensity(plane, y, density);
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			_mm_storeu_ps(row + i * 4, density[i]);
+		}
+#else
+		RowDensity(plane, y, row);
+#endif
+	}
+}
+
+void DensityField::SelectSlice(unsigned int x, unsigned int minY, unsigned int maxY, const float* bias, uint8_t block, uint8_t* slice) const
+{
+	if (maxY <= minY)
+	{
+		return;
+	}
+
+	float plane[SamplesY * SamplesXZ];
+	unsigned int sx = x / CellWidth;
+	BuildPlane(&_samples[sx][0][0], &_samples[sx + 1][0][0], (x % CellWidth) * (1.0f / CellWidth), minY / CellHeight, (maxY - 1) / CellHeight + 1, plane);
+
+	for (unsigned int y = minY; y < maxY; y++)
+	{
+		const float* rowBias = bias + (y - minY) * CHUNK_WIDTH;
+		uint8_t* row = slice + y * CHUNK_WIDTH;
+
+#ifdef BOSSCRAFT_DENSITY_SSE2
+		__m128 density[4];
+		RowDensity(plane, y, density);
+
+		const __m128 zero = _mm_setzero_ps();
+		__m128i masks[4];
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			masks[i] = _mm_castps_si128(_mm_cmpgt_ps(_mm_add_ps(density[i], _mm_loadu_ps(rowBias + i * 4)), zero));
+		}
+
+		// 32 bit lane masks (0 or -1) saturate down to 0x00/0xFF bytes
+		__m128i mask = _mm_packs_epi16(_mm_packs_epi32(masks[0], masks[1]), _mm_packs_epi32(masks[2], masks[3]));
+		__m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row));
+		__m128i selected = _mm_or_si128(_mm_and_si128(mask, _mm_set1_epi8(static_cast<char>(block))), _mm_andnot_si128(mask, current));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(row), selected);
+#else
+		float density[CHUNK_WIDTH];
+		RowDensity(plane, y, density);
+		for (unsigned int z = 0; z < CHUNK_WIDTH; z++)
+		{
+			if (density[z] + rowBias[z] > 0.0f)
+			{
+				row[z] = block;
+			}
+		}
+#endif
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <FastNoiseLite.h>
+#include <glm/vec2.hpp>
+
+#include "Chunk.h"
+
+/**
+ * 3D noise for one chunk, sampled on a coarse lattice (one sample per CellWidth x CellHeight x CellWidth blocks) and
+ * trilinearly upsampled one x slice at a time, a whole z row per SSE pass. A full chunk is at most 5x9x5 noise calls instead of one per
+ * block, which keeps 3D terrain in the same cost range as the 2D heightmap.
+ */
+class DensityField
+{
+public:
+	static const unsigned int CellWidth = 4;
+	static const unsigned int CellHeight = 8;
+	static const unsigned int SamplesXZ = CHUNK_WIDTH / CellWidth + 1;
+	static const unsigned int SamplesY = CHUNK_HEIGHT / CellHeight + 1;
+
+private:
+	float _samples[SamplesXZ][SamplesY][SamplesXZ];
+
+public:
+	// Samples the lattice layers needed to interpolate blocks minY <= y < maxY. yScale stretches the noise vertically.
+	void Sample(FastNoiseLite& noise, glm::ivec2 chunkPos, unsigned int minY, unsigned int maxY, float yScale);
+
+	// out[(y - minY) * CHUNK_WIDTH + z] = density at (x, y, z) for minY <= y < maxY, inside the sampled range
+	void InterpolateSlice(unsigned int x, unsigned int minY, unsigned int maxY, float* out) const;
+
+	// For the x slice of a chunk (Chunk's layout, y rows of z): slice[y * CHUNK_WIDTH + z] = block wherever
+	// density + bias[(y - minY) * CHUNK_WIDTH + z] > 0, for minY <= y < maxY. Other blocks are left alone.
+	void SelectSlice(unsigned int x, unsigned int minY, unsigned int maxY, const float* bias, uint8_t block, uint8_t* slice) const;
+};
@@ -0,0 +1,69 @@
+#include "GLRenderBackend.h"
+
+#include <glad/glad.h>
+
+#include "Shader.h"
+#include "TextureAtlas.h"
+
+GLRenderBackend::GLRenderBackend(Shader* shader, TextureAtlas* atlas) : _shader(shader), _textureAtlas(atlas)
+{
+}
+
+void GLRenderBackend::SetProjection(const glm::mat4& projection)
+{
+	_shader->Use();
+	_shader->UniSetMat4f("projection", projection);
+}
+
+void GLRenderBackend::BeginFrame(const glm::mat4& view)
+{
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, _textureAtlas->_textureID);
+
+	_shader->Use();
+	_shader->SetViewMatrix(view);
+}
+
+ChunkRenderHandle GLRenderBackend::CreateChunkBuffers()
+{
+	ChunkRenderHandle handle{};
+	glGenVertexArrays(1, &handle.VAO);
+	glGenBuffers(1, &handle.VBO);
+	glGenBuffers(1, &handle.EBO);
+
+	glBindVertexArray(handle.VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, handle.VBO);
+	// position attribute
+	glVertexAttribPointer(0, 1, GL_FLOAT, GL_FALSE, sizeof(uint32_t), (void*)0);
+	glEnableVertexAttribArray(0);
+
+	glBindVertexArray(0);
+	return handle;
+}
+
+void GLRenderBackend::UploadChunkMesh(const ChunkRenderHandle& handle, const uint32_t* vertexData, size_t vertexCount,
+	const uint16_t* indexData, size_t indexCount)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, handle.VBO);
+	glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(uint32_t), vertexData, GL_STATIC_DRAW);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, handle.EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(uint16_t), indexData, GL_STATIC_DRAW);
+}
+
+void GLRenderBackend::DrawChunk(const ChunkRenderHandle& handle, const glm::mat4& model, unsigned int indexCount)
+{
+	_shader->SetModel(model);
+
+	glBindVertexArray(handle.VAO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, handle.EBO);
+	glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, 0);
+	glBindVertexArray(0);
+}
+
+void GLRenderBackend::DestroyChunkBuffers(const ChunkRenderHandle& handle)
+{
+	glDeleteVertexArrays(1, &handle.VAO);
+	glDeleteBuffers(1, &handle.VBO);
+	glDeleteBuffers(1, &handle.EBO);
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "IRenderBackend.h"
+
+class Shader;
+class TextureAtlas;
+
+/**
+ * OpenGL 3.3 core implementation. Needs a current context with glad loaded.
+ */
+class GLRenderBackend : public IRenderBackend
+{
+private:
+	Shader* _shader;
+	TextureAtlas* _textureAtlas;
+
+public:
+	GLRenderBackend(Shader* shader, TextureAtlas* atlas);
+
+	void SetProjection(const glm::mat4& projection) override;
+	void BeginFrame(const glm::mat4& view) override;
+
+	ChunkRenderHandle CreateChunkBuffers() override;
+	void UploadChunkMesh(const ChunkRenderHandle& handle, const uint32_t* vertexData, size_t vertexCount,
+		const uint16_t* indexData, size_t indexCount) override;
+	void DrawChunk(const ChunkRenderHandle& handle, const glm::mat4& model, unsigned int indexCount) override;
+	void DestroyChunkBuffers(const ChunkRenderHandle& handle) override;
+};
@@ -0,0 +1,36 @@
+#include "GenerationContext.h"
+
+#include <cmath>
+
+void GenerationContext::WriteBlock(glm::ivec3 localPos, uint8_t block, bool replaceSolid)
+{
+	if (localPos.y < 0 || localPos.y >= static_cast<int>(CHUNK_HEIGHT))
+	{
+		return;
+	}
+
+	glm::ivec2 chunkOffset(
+		static_cast<int>(floorf(localPos.x / static_cast<float>(CHUNK_WIDTH))),
+		static_cast<int>(floorf(localPos.z / static_cast<float>(CHUNK_WIDTH))));
+	if (chunkOffset == glm::ivec2(0, 0))
+	{
+		uint8_t& current = blocks[Index(localPos.x, localPos.y, localPos.z)];
+		if (replaceSolid || current == 0)
+		{
+			current = block;
+		}
+		return;
+	}
+
+	glm::ivec2 target = chunkPos + chunkOffset;
+	glm::u8vec3 targetPos(localPos.x - chunkOffset.x * static_cast<int>(CHUNK_WIDTH), localPos.y, localPos.z - chunkOffset.y * static_cast<int>(CHUNK_WIDTH));
+	for (auto& writes : outgoing)
+	{
+		if (writes.first == target)
+		{
+			writes.second.emplace_back(PendingBlockWrites::Write{ targetPos, block, replaceSolid });
+			return;
+		}
+	}
+	outgoing.emplace_back(target, std::vector<PendingBlockWrites::Write>{ PendingBlockWrites::Write{ targetPos, block, replaceSolid } });
+}
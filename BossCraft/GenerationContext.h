@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include "Chunk.h"
+#include "PendingBlockWrites.h"
+
+class HeightmapCache;
+
+// Everything a generation stage may read or write for one chunk
+struct GenerationContext
+{
+	glm::ivec2 chunkPos;
+	int seed;
+	// CHUNK_VOLUME blocks in Chunk's layout, see Index
+	uint8_t* blocks;
+	// Terrain height of each column, [x * CHUNK_WIDTH + z]
+	uint8_t heights[CHUNK_WIDTH * CHUNK_WIDTH];
+	HeightmapCache* heightmapCache;
+	// Writes that landed outside this chunk, per target chunk; ChunkGenerator hands them to PendingBlockWrites
+	std::vector<std::pair<glm::ivec2, std::vector<PendingBlockWrites::Write>>> outgoing;
+
+	static unsigned int Index(unsigned int x, unsigned int y, unsigned int z)
+	{
+		return x * CHUNK_HEIGHT * CHUNK_WIDTH + y * CHUNK_WIDTH + z;
+	}
+
+	glm::ivec2 ChunkOrigin() const
+	{
+		return chunkPos * static_cast<int>(CHUNK_WIDTH);
+	}
+
+	// localPos may be outside the chunk on x/z, the write is then deferred to the chunk that owns it.
+	// Writes above or below the world are dropped.
+	void WriteBlock(glm::ivec3 localPos, uint8_t block, bool replaceSolid);
+};
@@ -0,0 +1,203 @@
+#include "GenerationStages.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <FastNoiseLite.h>
+
+#include "BlockProvider.h"
+#include "DensityField.h"
+
+namespace
+{
+	int HashCell(int seed, int x, int z)
+	{
+		// Same mixing as FastNoiseLite's coordinate hash
+		int hash = seed ^ (x * 501125321) ^ (z * 1136930381);
+		hash *= 0x27d4eb2d;
+		hash ^= hash >> 15;
+		return hash;
+	}
+
+	int FloorDiv(int value, int divisor)
+	{
+		return static_cast<int>(floorf(value / static_cast<float>(divisor)));
+	}
+}
+
+void TerrainStage::Generate(GenerationContext& context)
+{
+	unsigned int minHeight = CHUNK_HEIGHT;
+	unsigned int maxHeight = 0;
+	for (unsigned int i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++)
+	{
+		minHeight = std::min<unsigned int>(minHeight, context.heights[i]);
+		maxHeight = std::max<unsigned int>(maxHeight, context.heights[i]);
+	}
+
+	// Only rows within the noise amplitude of some column's height can go either way; the bottom row is always stone
+	unsigned int bandStart = std::max<int>(1, static_cast<int>(minHeight) - static_cast<int>(_overhangAmplitude));
+	unsigned int bandEnd = std::min(CHUNK_HEIGHT, maxHeight + _overhangAmplitude);
+
+	FastNoiseLite noise(context.seed + 2);
+	noise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
+	noise.SetFrequency(_frequency);
+	DensityField field;
+	field.Sample(noise, context.chunkPos, bandStart, bandEnd, 1.0f);
+
+	// Solid where height - y + amplitude * noise > 0, i.e. noise + (height - y) / amplitude > 0
+	const float invAmplitude = 1.0f / _overhangAmplitude;
+	for (unsigned int x = 0; x < CHUNK_WIDTH; x++)
+	{
+		const uint8_t* heights = &context.heights[x * CHUNK_WIDTH];
+
+		// An x slice is contiguous (y rows of z)
+		uint8_t* slice = &context.blocks[GenerationContext::Index(x, 0, 0)];
+		memset(slice, BLOCK_STONE, bandStart * CHUNK_WIDTH);
+		memset(slice + bandStart * CHUNK_WIDTH, BLOCK_AIR, (CHUNK_HEIGHT - bandStart) * CHUNK_WIDTH);
+
+		float bias[CHUNK_HEIGHT * CHUNK_WIDTH];
+		for (unsigned int y = bandStart; y < bandEnd; y++)
+		{
+			for (unsigned int z = 0; z < CHUNK_WIDTH; z++)
+			{
+				bias[(y - bandStart) * CHUNK_WIDTH + z] = (static_cast<float>(heights[z]) - y - 0.5f) * invAmplitude;
+			}
+		}
+		field.SelectSlice(x, bandStart, bandEnd, bias, BLOCK_STONE, slice);
+	}
+
+	for (unsigned int x = 0; x < CHUNK_WIDTH; x++)
+	{
+		for (unsigned int z = 0; z < CHUNK_WIDTH; z++)
+		{
+			unsigned int top = bandEnd;
+			while (top > bandStart && context.blocks[GenerationContext::Index(x, top - 1, z)] == BLOCK_AIR)
+			{
+				top--;
+			}
+			context.heights[x * CHUNK_WIDTH + z] = static_cast<uint8_t>(top);
+		}
+	}
+}
+
+void CaveStage::Generate(GenerationContext& context)
+{
+	unsigned int maxRoof = 0;
+	for (unsigned int i = 0; i < CHUNK_WIDTH * CHUNK_WIDTH; i++)
+	{
+		maxRoof = std::max<unsigned int>(maxRoof, context.heights[i] > _roofThickness ? context.heights[i] - _roofThickness : 0);
+	}
+	if (maxRoof <= _floor)
+	{
+		return;
+	}
+
+	FastNoiseLite noise(context.seed + 1);
+	noise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
+	noise.SetFrequency(_frequency);
+	DensityField field;
+	// Squash vertically so caves run sideways more than they drop
+	field.Sample(noise, context.chunkPos, _floor, maxRoof, 1.5f);
+
+	for (unsigned int x = 0; x < CHUNK_WIDTH; x++)
+	{
+		const uint8_t* heights = &context.heights[x * CHUNK_WIDTH];
+		float bias[CHUNK_HEIGHT * CHUNK_WIDTH];
+		for (unsigned int y = _floor; y < maxRoof; y++)
+		{
+			// Columns whose roof is below this row must not be carved
+			for (unsigned int z = 0; z < CHUNK_WIDTH; z++)
+			{
+				bias[(y - _floor) * CHUNK_WIDTH + z] = y + _roofThickness < heights[z] ? -_threshold : -2.0f;
+			}
+		}
+		field.SelectSlice(x, _floor, maxRoof, bias, BLOCK_AIR, &context.blocks[GenerationContext::Index(x, 0, 0)]);
+	}
+}
+
+void SurfaceStage::Generate(GenerationContext& context)
+{
+	for (unsigned int x = 0; x < CHUNK_WIDTH; x++)
+	{
+		for (unsigned int z = 0; z < CHUNK_WIDTH; z++)
+		{
+			unsigned int height = context.heights[x * CHUNK_WIDTH + z];
+			for (unsigned int depth = 0; depth <= _dirtDepth && depth < height; depth++)
+			{
+				uint8_t& block = context.blocks[GenerationContext::Index(x, height - 1 - depth, z)];
+				if (block == BLOCK_STONE)
+				{
+					block = depth == 0 ? BLOCK_GRASS : BLOCK_DIRT;
+				}
+			}
+		}
+	}
+}
+
+void TreeStage::Generate(GenerationContext& context)
+{
+	glm::ivec2 origin = context.ChunkOrigin();
+	int lastColumnX = origin.x + static_cast<int>(CHUNK_WIDTH) - 1;
+	int lastColumnZ = origin.y + static_cast<int>(CHUNK_WIDTH) - 1;
+
+	for (int cellX = FloorDiv(origin.x, _cellSize); cellX <= FloorDiv(lastColumnX, _cellSize); cellX++)
+	{
+		for (int cellZ = FloorDiv(origin.y, _cellSize); cellZ <= FloorDiv(lastColumnZ, _cellSize); cellZ++)
+		{
+			int hash = HashCell(context.seed, cellX, cellZ);
+			if ((hash & 255) >= _chance)
+			{
+				continue;
+			}
+
+			// Keep one column of margin inside the cell so neighbouring trees never share a trunk column
+			glm::ivec2 column(cellX * _cellSize + 1 + ((hash >> 8) & 3), cellZ * _cellSize + 1 + ((hash >> 10) & 3));
+			glm::ivec2 local = column - origin;
+			if (local.x < 0 || local.x >= static_cast<int>(CHUNK_WIDTH) || local.y < 0 || local.y >= static_cast<int>(CHUNK_WIDTH))
+			{
+				continue;
+			}
+
+			unsigned int height = context.heights[local.x * CHUNK_WIDTH + local.y];
+			unsigned int trunk = _minTrunk + ((hash >> 12) & 1);
+			if (height == 0 || height + trunk + 2 > CHUNK_HEIGHT ||
+				context.blocks[GenerationContext::Index(local.x, height - 1, local.y)] != BLOCK_GRASS)
+			{
+				continue;
+			}
+			Stamp(context, local, height, trunk);
+		}
+	}
+}
+
+void TreeStage::Stamp(GenerationContext& context, glm::ivec2 local, unsigned int height, unsigned int trunk)
+{
+	int base = static_cast<int>(height);
+
+	context.WriteBlock(glm::ivec3(local.x, base - 1, local.y), BLOCK_DIRT, true);
+
+	for (unsigned int y = 0; y < trunk; y++)
+	{
+		context.WriteBlock(glm::ivec3(local.x, base + y, local.y), BLOCK_LOG, true);
+	}
+
+	// Two wide layers around the top of the trunk, then two narrow ones above it
+	for (int y = static_cast<int>(trunk) - 2; y <= static_cast<int>(trunk) + 1; y++)
+	{
+		int radius = y < static_cast<int>(trunk) ? _leafRadius : 1;
+		for (int dx = -radius; dx <= radius; dx++)
+		{
+			for (int dz = -radius; dz <= radius; dz++)
+			{
+				bool corner = std::abs(dx) == radius && std::abs(dz) == radius;
+				if (corner && (radius == _leafRadius || y == static_cast<int>(trunk) + 1))
+				{
+					continue;
+				}
+				context.WriteBlock(glm::ivec3(local.x + dx, base + y, local.y + dz), BLOCK_LEAVES, false);
+			}
+		}
+	}
+}
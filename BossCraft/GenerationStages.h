@@ -0,0 +1,63 @@
+#pragma once
+#include "IGenerationStage.h"
+
+// Stone up to the cached heightmap, pushed up and down by 3D noise so cliffs get overhangs. Afterwards the context
+// heights are the real surface (one above the highest solid block) rather than the heightmap.
+class TerrainStage : public IGenerationStage
+{
+private:
+	// How far (in blocks) the 3D noise can move the surface
+	static const unsigned int _overhangAmplitude = 6;
+	static constexpr float _frequency = 0.04f;
+
+public:
+	const char* GetName() override { return "Terrain"; }
+	void Generate(GenerationContext& context) override;
+};
+
+// Carves 3D noise caves, leaving the bottom layer and a roof under the surface intact
+class CaveStage : public IGenerationStage
+{
+private:
+	static const unsigned int _floor = 1;
+	static const unsigned int _roofThickness = 5;
+	static constexpr float _frequency = 0.045f;
+	static constexpr float _threshold = 0.55f;
+
+public:
+	const char* GetName() override { return "Caves"; }
+	void Generate(GenerationContext& context) override;
+};
+
+// Grass on top, a few blocks of dirt, stone below
+class SurfaceStage : public IGenerationStage
+{
+private:
+	static const unsigned int _dirtDepth = 3;
+
+public:
+	const char* GetName() override { return "Surface"; }
+	void Generate(GenerationContext& context) override;
+};
+
+/**
+ * Trees on a jittered grid of cells, at most one per cell, on grass that survived the cave pass. The chunk holding the
+ * trunk places the whole tree; leaves crossing the border are deferred to the neighbour through WriteBlock.
+ */
+class TreeStage : public IGenerationStage
+{
+private:
+	static const int _cellSize = 6;
+	static const unsigned int _minTrunk = 4;
+	// Out of 256 per cell
+	static const int _chance = 90;
+
+public:
+	const char* GetName() override { return "Trees"; }
+	void Generate(GenerationContext& context) override;
+
+private:
+	static const int _leafRadius = 2;
+
+	static void Stamp(GenerationContext& context, glm::ivec2 local, unsigned int height, unsigned int trunk);
+};
@@ -0,0 +1,122 @@
+#include "HeightmapCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Metrics.h"
+#include "Profiler.h"
+#include "TerrainNoise.h"
+
+HeightmapCache::HeightmapCache(TerrainNoise* noise, size_t maxTiles) : _noise(noise), _maxTiles(std::max<size_t>(1, maxTiles))
+{
+	_seed = noise->GetSeed();
+	_frequency = noise->GetFrequency();
+}
+
+std::shared_ptr<const HeightmapCache::Tile> HeightmapCache::GetTile(glm::ivec2 region)
+{
+	static Metrics::Counter& hits = Metrics::GetCounter("world.heightmap.hits");
+	static Metrics::Counter& misses = Metrics::GetCounter("world.heightmap.misses");
+	static Metrics::Counter& evictions = Metrics::GetCounter("world.heightmap.evictions");
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		// Tiles built under other noise settings describe a different world
+		if (_noise->GetSeed() != _seed || _noise->GetFrequency() != _frequency)
+		{
+			_tiles.clear();
+			_lru.clear();
+			_seed = _noise->GetSeed();
+			_frequency = _noise->GetFrequency();
+		}
+
+		auto it = _tiles.find(region);
+		if (it != _tiles.end())
+		{
+			_lru.splice(_lru.begin(), _lru, it->second.lruIt);
+			hits.Add();
+			return it->second.tile;
+		}
+	}
+
+	misses.Add();
+	std::shared_ptr<const Tile> tile = BuildTile(region);
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto it = _tiles.find(region);
+	if (it != _tiles.end())
+	{
+		return it->second.tile;
+	}
+
+	_lru.push_front(region);
+	_tiles[region] = Entry{ tile, _lru.begin() };
+	while (_tiles.size() > _maxTiles)
+	{
+		_tiles.erase(_lru.back());
+		_lru.pop_back();
+		evictions.Add();
+	}
+	return tile;
+}
+
+void HeightmapCache::GetChunkHeights(glm::ivec2 chunkPos, uint8_t* out)
+{
+	glm::ivec2 region = ChunkPosToRegion(chunkPos);
+	std::shared_ptr<const Tile> tile = GetTile(region);
+
+	glm::ivec2 offset = (chunkPos - region * static_cast<int>(TileChunks)) * static_cast<int>(CHUNK_WIDTH);
+	for (unsigned int x = 0; x < CHUNK_WIDTH; x++)
+	{
+		memcpy(out + x * CHUNK_WIDTH, &tile->heights[(offset.x + x) * TileColumns + offset.y], CHUNK_WIDTH);
+	}
+}
+
+unsigned int HeightmapCache::GetColumnHeight(glm::ivec2 column)
+{
+	glm::ivec2 region(
+		static_cast<int>(floorf(column.x / static_cast<float>(TileColumns))),
+		static_cast<int>(floorf(column.y / static_cast<float>(TileColumns))));
+	std::shared_ptr<const Tile> tile = GetTile(region);
+
+	glm::ivec2 offset = column - region * static_cast<int>(TileColumns);
+	return tile->heights[offset.x * TileColumns + offset.y];
+}
+
+glm::ivec2 HeightmapCache::ChunkPosToRegion(glm::ivec2 chunkPos)
+{
+	return glm::ivec2(
+		static_cast<int>(floorf(chunkPos.x / static_cast<float>(TileChunks))),
+		static_cast<int>(floorf(chunkPos.y / static_cast<float>(TileChunks))));
+}
+
+unsigned int HeightmapCache::HeightFromNoise(float noise)
+{
+	unsigned int height = floor((noise + 1) * 5 + (CHUNK_HEIGHT / 2.f));
+	return std::min(height, CHUNK_HEIGHT - 1);
+}
+
+void HeightmapCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_tiles.clear();
+	_lru.clear();
+}
+
+std::shared_ptr<const HeightmapCache::Tile> HeightmapCache::BuildTile(glm::ivec2 region)
+{
+	PROFILE_SCOPE("HeightmapCache::BuildTile");
+	std::shared_ptr<Tile> tile = std::make_shared<Tile>();
+	tile->region = region;
+
+	std::unique_ptr<float[]> noise(new float[TileColumns * TileColumns]);
+	glm::ivec2 origin = region * static_cast<int>(TileColumns);
+	_noise->GetNoiseGrid(origin.x, origin.y, TileColumns, TileColumns, noise.get());
+
+	for (unsigned int i = 0; i < TileColumns * TileColumns; i++)
+	{
+		tile->heights[i] = static_cast<uint8_t>(HeightFromNoise(noise[i]));
+	}
+	return tile;
+}
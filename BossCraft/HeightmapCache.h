@@ -0,0 +1,69 @@
+#pragma once
+#define GLM_ENABLE_EXPERIMENTAL
+#include <array>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "glm/gtx/hash.hpp"
+
+#include "Chunk.h"
+
+class TerrainNoise;
+
+/**
+ * Terrain column heights cached in square tiles of TileChunks x TileChunks chunks, least recently used tile evicted
+ * first. Regenerating a chunk, meshing its neighbours or re-entering an area reads heights back without touching the
+ * noise, and anything that only needs the surface (far terrain, LODs) can sample tiles directly.
+ *
+ * Safe to call from any job thread. Tiles are immutable once built; two threads missing the same tile may both build
+ * it and the first one in wins.
+ */
+class HeightmapCache
+{
+public:
+	static const unsigned int TileChunks = 4;
+	static const unsigned int TileColumns = TileChunks * CHUNK_WIDTH;
+
+	struct Tile
+	{
+		glm::ivec2 region;
+		// Blocks below this height are solid, indexed [x * TileColumns + z]
+		std::array<uint8_t, TileColumns * TileColumns> heights;
+	};
+
+private:
+	struct Entry
+	{
+		std::shared_ptr<const Tile> tile;
+		std::list<glm::ivec2>::iterator lruIt;
+	};
+
+	TerrainNoise* _noise;
+	size_t _maxTiles;
+	int _seed;
+	float _frequency;
+
+	std::mutex _mutex;
+	std::unordered_map<glm::ivec2, Entry> _tiles;
+	std::list<glm::ivec2> _lru;
+
+public:
+	HeightmapCache(TerrainNoise* noise, size_t maxTiles);
+
+	std::shared_ptr<const Tile> GetTile(glm::ivec2 region);
+
+	// Fills out[x * CHUNK_WIDTH + z] with the column heights of one chunk
+	void GetChunkHeights(glm::ivec2 chunkPos, uint8_t* out);
+	unsigned int GetColumnHeight(glm::ivec2 column);
+
+	static glm::ivec2 ChunkPosToRegion(glm::ivec2 chunkPos);
+	static unsigned int HeightFromNoise(float noise);
+
+	void Clear();
+
+private:
+	std::shared_ptr<const Tile> BuildTile(glm::ivec2 region);
+};
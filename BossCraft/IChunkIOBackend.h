@@ -0,0 +1,36 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <memory>
+#include <vector>
+
+class Chunk;
+
+enum class ChunkIOOp
+{
+	Load,
+	Save,
+};
+
+struct ChunkIORequest
+{
+	ChunkIOOp op;
+	std::shared_ptr<Chunk> chunk;
+	std::string path;
+	// CHUNK_VOLUME bytes in the save file layout; a snapshot of the blocks for saves, filled into the chunk after loads
+	std::shared_ptr<uint8_t> buffer;
+	// Runs on an I/O thread, or in ChunkIO::Flush for a load served from a save that isn't written yet. success is false
+	// if a load found no (complete) save file.
+	std::function<void(std::shared_ptr<Chunk>, bool)> onComplete;
+};
+
+class IChunkIOBackend
+{
+public:
+	virtual ~IChunkIOBackend() = default;
+
+	virtual const char* GetName() = 0;
+
+	// Takes ownership of every request in the batch and starts them all before returning.
+	virtual void Submit(std::vector<ChunkIORequest>& batch) = 0;
+};
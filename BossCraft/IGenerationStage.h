@@ -0,0 +1,17 @@
+#pragma once
+#include "GenerationContext.h"
+
+/**
+ * One pass of procedural generation. Stages run in order on a job thread, one chunk at a time, and may be called for
+ * many chunks at once, so anything they share must be read only or locked. A stage that needs data from outside its
+ * chunk derives it from the seed (or a shared cache) rather than reading neighbouring chunks, which may not exist yet,
+ * and writes outside its chunk go through GenerationContext::WriteBlock.
+ */
+class IGenerationStage
+{
+public:
+	virtual ~IGenerationStage() = default;
+
+	virtual const char* GetName() = 0;
+	virtual void Generate(GenerationContext& context) = 0;
+};
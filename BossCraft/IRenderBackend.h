@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <glm/mat4x4.hpp>
+
+// GPU objects owned by one chunk. All zero means nothing was created yet.
+struct ChunkRenderHandle
+{
+	unsigned int VAO;
+	unsigned int VBO;
+	unsigned int EBO;
+};
+
+/**
+ * Everything World and Chunk need from the GPU. All calls are main thread only.
+ */
+class IRenderBackend
+{
+public:
+	virtual ~IRenderBackend() = default;
+
+	virtual void SetProjection(const glm::mat4& projection) = 0;
+	virtual void BeginFrame(const glm::mat4& view) = 0;
+
+	virtual ChunkRenderHandle CreateChunkBuffers() = 0;
+	virtual void UploadChunkMesh(const ChunkRenderHandle& handle, const uint32_t* vertexData, size_t vertexCount,
+		const uint16_t* indexData, size_t indexCount) = 0;
+	virtual void DrawChunk(const ChunkRenderHandle& handle, const glm::mat4& model, unsigned int indexCount) = 0;
+	virtual void DestroyChunkBuffers(const ChunkRenderHandle& handle) = 0;
+};
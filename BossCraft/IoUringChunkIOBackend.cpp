@@ -0,0 +1,317 @@
+#include "IoUringChunkIOBackend.h"
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "Chunk.h"
+#include "Platform.h"
+#include "Profiler.h"
+
+static int IoUringSetup(unsigned int entries, io_uring_params* params)
+{
+	return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int IoUringRegister(int ringFd, unsigned int opcode, void* arg, unsigned int count)
+{
+	return static_cast<int>(syscall(__NR_io_uring_register, ringFd, opcode, arg, count));
+}
+
+static int IoUringEnter(int ringFd, unsigned int toSubmit, unsigned int minComplete, unsigned int flags)
+{
+	return static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+IoUringChunkIOBackend::IoUringChunkIOBackend() : _ringFd(-1), _entries(0), _sqRing(MAP_FAILED), _sqRingSize(0),
+	_cqRing(MAP_FAILED), _cqRingSize(0), _sqeMemory(MAP_FAILED), _sqeMemorySize(0), _tail(0), _inFlight(0)
+{
+}
+
+IoUringChunkIOBackend::~IoUringChunkIOBackend()
+{
+	if (_reaper.joinable())
+	{
+		while (_inFlight.load() > 0)
+		{
+			std::this_thread::yield();
+		}
+		// With nothing else in flight, the reaper exits on this one's completion
+		{
+			std::lock_guard<std::mutex> lock(_submitMutex);
+			NextSqe(nullptr)->opcode = IORING_OP_NOP;
+		}
+		SubmitQueued(true);
+		_reaper.join();
+	}
+
+	if (_sqRing != MAP_FAILED)
+	{
+		munmap(_sqRing, _sqRingSize);
+	}
+	if (_cqRing != MAP_FAILED)
+	{
+		munmap(_cqRing, _cqRingSize);
+	}
+	if (_sqeMemory != MAP_FAILED)
+	{
+		munmap(_sqeMemory, _sqeMemorySize);
+	}
+	if (_ringFd >= 0)
+	{
+		close(_ringFd);
+	}
+}
+
+IoUringChunkIOBackend* IoUringChunkIOBackend::Create(unsigned int entries)
+{
+	IoUringChunkIOBackend* backend = new IoUringChunkIOBackend();
+	if (!backend->Setup(entries))
+	{
+		delete backend;
+		return nullptr;
+	}
+
+	backend->_reaper = std::thread([backend] { backend->Reap(); });
+	Platform::SetThreadName(backend->_reaper, "ChunkIO_Reaper");
+	return backend;
+}
+
+bool IoUringChunkIOBackend::Setup(unsigned int entries)
+{
+	io_uring_params params{};
+	_ringFd = IoUringSetup(entries, &params);
+	if (_ringFd < 0)
+	{
+		return false;
+	}
+	_entries = params.sq_entries;
+
+	_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	_sqeMemorySize = params.sq_entries * sizeof(io_uring_sqe);
+
+	// Whatever was mapped is released by the destructor
+	_sqRing = mmap(nullptr, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQ_RING);
+	_cqRing = mmap(nullptr, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_CQ_RING);
+	_sqeMemory = mmap(nullptr, _sqeMemorySize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQES);
+	if (_sqRing == MAP_FAILED || _cqRing == MAP_FAILED || _sqeMemory == MAP_FAILED)
+	{
+		return false;
+	}
+
+	char* sq = static_cast<char*>(_sqRing);
+	_sqHead = reinterpret_cast<unsigned int*>(sq + params.sq_off.head);
+	_sqTail = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+	_sqMask = reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_mask);
+	_sqArray = reinterpret_cast<unsigned int*>(sq + params.sq_off.array);
+	_sqes = static_cast<io_uring_sqe*>(_sqeMemory);
+	_tail = *_sqTail;
+
+	char* cq = static_cast<char*>(_cqRing);
+	_cqHead = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+	_cqTail = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+	_cqMask = reinterpret_cast<unsigned int*>(cq + params.cq_off.ring_mask);
+	_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+	return SupportsOp(IORING_OP_OPENAT) && SupportsOp(IORING_OP_READV) && SupportsOp(IORING_OP_WRITEV);
+}
+
+bool IoUringChunkIOBackend::SupportsOp(unsigned int op)
+{
+	const unsigned int maxOps = 256;
+	std::vector<char> storage(sizeof(io_uring_probe) + maxOps * sizeof(io_uring_probe_op), 0);
+	io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+	// Probing came in with OPENAT, so a kernel without it fails here
+	if (IoUringRegister(_ringFd, IORING_REGISTER_PROBE, probe, maxOps) < 0)
+	{
+		return false;
+	}
+	return op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0;
+}
+
+const char* IoUringChunkIOBackend::GetName()
+{
+	return "io_uring";
+}
+
+void IoUringChunkIOBackend::Submit(std::vector<ChunkIORequest>& batch)
+{
+	for (ChunkIORequest& request : batch)
+	{
+		// Keep the ring from overflowing the completion queue; submit what we have and wait for the reaper
+		if (_inFlight.load() >= _entries)
+		{
+			SubmitQueued(true);
+			while (_inFlight.load() >= _entries)
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		InFlight* op = new InFlight{ std::move(request), -1, {} };
+		op->iov.iov_base = op->request.buffer.get();
+		op->iov.iov_len = CHUNK_VOLUME;
+		_inFlight.fetch_add(1);
+
+		// Opening can block on the directory, so the kernel does it too; the reaper queues the read or write after
+		std::lock_guard<std::mutex> lock(_submitMutex);
+		io_uring_sqe* sqe = NextSqe(op);
+		sqe->opcode = IORING_OP_OPENAT;
+		sqe->fd = AT_FDCWD;
+		sqe->addr = reinterpret_cast<unsigned long long>(op->request.path.c_str());
+		if (op->request.op == ChunkIOOp::Load)
+		{
+			sqe->open_flags = O_RDONLY | O_CLOEXEC;
+		}
+		else
+		{
+			sqe->open_flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+			sqe->len = 0644;
+		}
+	}
+
+	SubmitQueued(true);
+	batch.clear();
+}
+
+// The next free SQE, cleared and tagged with op. Call with _submitMutex held.
+io_uring_sqe* IoUringChunkIOBackend::NextSqe(InFlight* op)
+{
+	unsigned int index = _tail & *_sqMask;
+	io_uring_sqe* sqe = &_sqes[index];
+	*sqe = {};
+	sqe->user_data = reinterpret_cast<unsigned long long>(op);
+	_sqArray[index] = index;
+	_tail++;
+	return sqe;
+}
+
+/**
+ * Enters until the kernel has taken every queued SQE. It may take fewer than asked, or refuse for a moment while
+ * completions back up; with retry those are tried again, otherwise it returns false and leaves them queued. On any
+ * other error the SQEs it didn't take are pulled back off the ring and their requests fail.
+ */
+bool IoUringChunkIOBackend::SubmitQueued(bool retry)
+{
+	std::vector<InFlight*> failed;
+	int error = 0;
+	std::unique_lock<std::mutex> lock(_submitMutex);
+	__atomic_store_n(_sqTail, _tail, __ATOMIC_RELEASE);
+	while (true)
+	{
+		unsigned int head = __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+		if (head == _tail)
+		{
+			break;
+		}
+		int submitted = IoUringEnter(_ringFd, _tail - head, 0, 0);
+		int enterError = submitted < 0 ? errno : 0;
+		if (submitted > 0)
+		{
+			continue;
+		}
+		if (enterError == EINTR || enterError == EAGAIN || enterError == EBUSY)
+		{
+			if (!retry)
+			{
+				return false;
+			}
+			// The reaper may need the lock to make room
+			lock.unlock();
+			std::this_thread::yield();
+			lock.lock();
+			__atomic_store_n(_sqTail, _tail, __ATOMIC_RELEASE);
+			continue;
+		}
+
+		error = enterError != 0 ? -enterError : -EIO;
+		for (unsigned int i = head; i != _tail; i++)
+		{
+			failed.emplace_back(reinterpret_cast<InFlight*>(_sqes[_sqArray[i & *_sqMask]].user_data));
+		}
+		_tail = head;
+		__atomic_store_n(_sqTail, _tail, __ATOMIC_RELEASE);
+		break;
+	}
+	lock.unlock();
+
+	for (InFlight* op : failed)
+	{
+		Finish(op, error);
+	}
+	return true;
+}
+
+void IoUringChunkIOBackend::Reap()
+{
+	PROFILE_THREAD_NAME("ChunkIO_Reaper");
+	while (true)
+	{
+		unsigned int head = *_cqHead;
+		if (head == __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE))
+		{
+			// Reads and writes queued below go out in one enter once the completions are drained
+			if (!SubmitQueued(false))
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			// Block until at least one completion arrives
+			if (IoUringEnter(_ringFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+			{
+				std::this_thread::yield();
+			}
+			continue;
+		}
+
+		io_uring_cqe* cqe = &_cqes[head & *_cqMask];
+		InFlight* op = reinterpret_cast<InFlight*>(cqe->user_data);
+		int result = cqe->res;
+		__atomic_store_n(_cqHead, head + 1, __ATOMIC_RELEASE);
+
+		if (op == nullptr)
+		{
+			// The destructor's NOP
+			return;
+		}
+		// Without an fd this is the open completing; a load of a chunk that was never saved fails here
+		if (op->fd < 0 && result >= 0)
+		{
+			op->fd = result;
+			std::lock_guard<std::mutex> lock(_submitMutex);
+			io_uring_sqe* sqe = NextSqe(op);
+			sqe->opcode = op->request.op == ChunkIOOp::Load ? IORING_OP_READV : IORING_OP_WRITEV;
+			sqe->fd = op->fd;
+			sqe->addr = reinterpret_cast<unsigned long long>(&op->iov);
+			sqe->len = 1;
+			sqe->off = 0;
+			continue;
+		}
+		Finish(op, result);
+	}
+}
+
+void IoUringChunkIOBackend::Finish(InFlight* op, int result)
+{
+	if (op->fd >= 0)
+	{
+		close(op->fd);
+	}
+	_inFlight.fetch_sub(1);
+	Complete(op, result);
+}
+
+void IoUringChunkIOBackend::Complete(InFlight* op, int result)
+{
+	PROFILE_SCOPE("ChunkIO::Complete");
+	if (op->request.onComplete)
+	{
+		op->request.onComplete(op->request.chunk, result == static_cast<int>(CHUNK_VOLUME));
+	}
+	delete op;
+}
+#endif // __linux__
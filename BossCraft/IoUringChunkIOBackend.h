@@ -0,0 +1,78 @@
+#pragma once
+#ifdef __linux__
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <sys/uio.h>
+
+#include "IChunkIOBackend.h"
+
+/**
+ * Linux io_uring backend, talking to the kernel through the raw syscalls so no liburing is needed.
+ * One batch becomes one io_uring_enter of OPENATs; a single reaper thread drains completions, queues the read or write
+ * for each file opened and runs the callbacks.
+ */
+class IoUringChunkIOBackend : public IChunkIOBackend
+{
+private:
+	struct InFlight
+	{
+		ChunkIORequest request;
+		// -1 until the open completes
+		int fd;
+		iovec iov;
+	};
+
+	int _ringFd;
+	unsigned int _entries;
+
+	// The three mappings, unmapped in the destructor
+	void* _sqRing;
+	size_t _sqRingSize;
+	void* _cqRing;
+	size_t _cqRingSize;
+	void* _sqeMemory;
+	size_t _sqeMemorySize;
+
+	// Submission queue ring (mmapped)
+	unsigned int* _sqHead;
+	unsigned int* _sqTail;
+	unsigned int* _sqMask;
+	unsigned int* _sqArray;
+	struct io_uring_sqe* _sqes;
+	// SQEs are written up to here; *_sqTail only moves on to it in SubmitQueued
+	unsigned int _tail;
+	// Guards the submission queue; Submit and the reaper both queue SQEs
+	std::mutex _submitMutex;
+
+	// Completion queue ring (mmapped)
+	unsigned int* _cqHead;
+	unsigned int* _cqTail;
+	unsigned int* _cqMask;
+	struct io_uring_cqe* _cqes;
+
+	// Requests handed to the kernel and not completed yet, counted before their SQE is submitted
+	std::atomic<unsigned int> _inFlight;
+	std::thread _reaper;
+
+	IoUringChunkIOBackend();
+
+public:
+	// Returns nullptr if io_uring is unavailable (old kernel, seccomp, container policy) or can't open files (before 5.6)
+	static IoUringChunkIOBackend* Create(unsigned int entries);
+	// Waits for every request in flight to complete, then stops the reaper and releases the ring
+	~IoUringChunkIOBackend() override;
+
+	const char* GetName() override;
+	void Submit(std::vector<ChunkIORequest>& batch) override;
+
+private:
+	bool Setup(unsigned int entries);
+	bool SupportsOp(unsigned int op);
+	struct io_uring_sqe* NextSqe(InFlight* op);
+	bool SubmitQueued(bool retry);
+	void Reap();
+	void Finish(InFlight* op, int result);
+	void Complete(InFlight* op, int result);
+};
+#endif // __linux__
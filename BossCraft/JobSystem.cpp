@@ -1,29 +1,38 @@
 #include "JobSystem.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <sstream>
-#include <windows.h>
+#include <thread>
+
+#include "Metrics.h"
+#include "Platform.h"
+#include "Profiler.h"
 
 unsigned int JobSystem::_numThreads = 0;
-ConcurrentRingBuffer<std::function<void()>, 256> JobSystem::_jobPool;
+ConcurrentRingBuffer<JobSystem::QueuedJob, 256> JobSystem::_jobPool;
 std::condition_variable JobSystem::_wakeCondition;
 std::mutex JobSystem::_wakeMutex;
-uint64_t JobSystem::_currentLabel = 0;
+std::atomic<uint64_t> JobSystem::_currentLabel;
 std::atomic<uint64_t> JobSystem::_finishedLabel;
 
 void JobSystem::Init()
 {
+	_currentLabel.store(0);
 	_finishedLabel.store(0);
 	unsigned int  numCores = std::thread::hardware_concurrency();
-	_numThreads = max(1u, numCores - 1);
+	_numThreads = std::max(1u, numCores - 1);
 
 	// Create all our worker threads while immediately starting them:
 	for (uint32_t threadID = 0; threadID < _numThreads; ++threadID)
 	{
-		std::thread worker([] {
+		std::thread worker([threadID] {
+			PROFILE_THREAD_NAME("JobSystem_" + std::to_string(threadID));
+			Metrics::Counter& jobsExecuted = Metrics::GetCounter("jobs.executed.worker" + std::to_string(threadID));
+			Metrics::Histogram& queuedUs = Metrics::GetHistogram("jobs.queuedUs");
 
-			std::function<void()> job; // the current job for the thread, it's empty at start.
+			QueuedJob job; // the current job for the thread, it's empty at start.
 
 									   // This is the infinite loop that a worker thread will do 
 			while (true)
@@ -31,8 +40,14 @@ void JobSystem::Init()
 				if (_jobPool.Dequeue(job)) // try to grab a job from the jobPool queue
 				{
 					// It found a job, execute it:
-					job(); // execute job
+					queuedUs.Record((Profiler::NowNs() - job.enqueuedNs) / 1000);
+					{
+						PROFILE_SCOPE("Job");
+						job.job(); // execute job
+					}
+					job.job = nullptr; // release the captures now rather than when the next job arrives
 					_finishedLabel.fetch_add(1); // update worker label state
+					jobsExecuted.Add();
 				}
 				else
 				{
@@ -44,25 +59,13 @@ void JobSystem::Init()
 
 			});
 
-#ifdef _WIN32
-		// Do Windows-specific thread setup:
-		HANDLE handle = (HANDLE)worker.native_handle();
-
-		// Put each thread on to dedicated core
-		DWORD_PTR affinityMask = 1ull << threadID;
-		DWORD_PTR affinity_result = SetThreadAffinityMask(handle, affinityMask);
-		assert(affinity_result > 0);
-
-		// Increase thread priority:
-		//BOOL priority_result = SetThreadPriority(handle, THREAD_PRIORITY_HIGHEST);
-		//assert(priority_result != 0);
+		// Put each thread on to dedicated core (best effort, restricted cpusets may refuse)
+		Platform::SetThreadAffinity(worker, threadID);
 
 		// Name the thread:
-		std::wstringstream wss;
-		wss << "JobSystem_" << threadID;
-		HRESULT hr = SetThreadDescription(handle, wss.str().c_str());
-		assert(SUCCEEDED(hr));
-#endif // _WIN32
+		std::stringstream ss;
+		ss << "JobSystem_" << threadID;
+		Platform::SetThreadName(worker, ss.str());
 
 		worker.detach(); // forget about this thread, let it do it's job in the infinite loop that we created above
 	}
@@ -72,12 +75,7 @@ void JobSystem::Execute(const std::function<void()>& job)
 {
 	_currentLabel++;
 
-	while (!_jobPool.Enqueue(job))
-	{
-		Poll();
-	}
-
-	_wakeCondition.notify_one();
+	Enqueue(job);
 }
 
 void JobSystem::Dispatch(uint32_t jobCount, uint32_t groupSize, const std::function<void(JobDispatchArgs)>& job)
@@ -100,7 +98,7 @@ void JobSystem::Dispatch(uint32_t jobCount, uint32_t groupSize, const std::funct
 
 			// Calculate the current group's offset into the jobs:
 			const uint32_t groupJobOffset = groupIndex * groupSize;
-			const uint32_t groupJobEnd = min(groupJobOffset + groupSize, jobCount);
+			const uint32_t groupJobEnd = std::min(groupJobOffset + groupSize, jobCount);
 
 			JobDispatchArgs args;
 			args.groupIndex = groupIndex;
@@ -114,9 +112,7 @@ void JobSystem::Dispatch(uint32_t jobCount, uint32_t groupSize, const std::funct
 		};
 
 		// Try to push a new job until it is pushed successfully:
-		while (!_jobPool.Enqueue(jobGroup)) { Poll(); }
-
-		_wakeCondition.notify_one(); // wake one thread
+		Enqueue(jobGroup);
 	}
 }
 
@@ -133,6 +129,40 @@ void JobSystem::Wait()
 	}
 }
 
+void JobSystem::Wait(const std::atomic<uint32_t>& counter)
+{
+	while (counter.load() > 0)
+	{
+		Poll();
+	}
+}
+
+size_t JobSystem::GetQueueDepth()
+{
+	return _jobPool.Size();
+}
+
+void JobSystem::Enqueue(const std::function<void()>& job)
+{
+	static Metrics::Counter& enqueueStalls = Metrics::GetCounter("jobs.enqueueStalls");
+	static Metrics::Counter& enqueueSpins = Metrics::GetCounter("jobs.enqueueSpins");
+
+	QueuedJob queuedJob{ job, Profiler::NowNs() };
+	if (!_jobPool.Enqueue(queuedJob))
+	{
+		// Pool is full; every retry below is a spin the caller could have spent elsewhere
+		PROFILE_SCOPE("JobSystem::EnqueueStall");
+		enqueueStalls.Add();
+		do
+		{
+			enqueueSpins.Add();
+			Poll();
+		} while (!_jobPool.Enqueue(queuedJob));
+	}
+
+	_wakeCondition.notify_one(); // wake one thread
+}
+
 void JobSystem::Poll()
 {
 	_wakeCondition.notify_one();
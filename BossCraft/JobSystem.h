@@ -1,4 +1,6 @@
 #pragma once
+#include <atomic>
+#include <condition_variable>
 #include <functional>
 
 #include "ConcurrentRingBuffer.h"
@@ -13,18 +15,24 @@ struct JobDispatchArgs
 class JobSystem
 {
 private:
+	struct QueuedJob
+	{
+		std::function<void()> job;
+		uint64_t enqueuedNs;
+	};
+
 	static unsigned int _numThreads;
-	static ConcurrentRingBuffer<std::function<void()>, 256> _jobPool;
+	static ConcurrentRingBuffer<QueuedJob, 256> _jobPool;
 	static std::condition_variable _wakeCondition;
 	static std::mutex _wakeMutex;
-	static uint64_t _currentLabel;
+	static std::atomic<uint64_t> _currentLabel;
 	static std::atomic<uint64_t> _finishedLabel;
 	
 public:
     // Create the internal resources such as worker threads, etc. Call it once when initializing the application.
     static void Init();
 
-	// Add a job to execute asynchronously. Any idle thread will execute this job.
+	// Add a job to execute asynchronously. Any idle thread will execute this job. Safe to call from I/O completion threads.
 	static void Execute(const std::function<void()>& job);
 
 	// Divide a job onto multiple jobs and execute in parallel.
@@ -39,7 +47,15 @@ public:
 	// Wait until all threads become idle
 	static void Wait();
 
+	// Wait until counter drops to zero. Jobs that decrement it when done can be waited on without waiting on everyone
+	// else's, some of which may be blocked on the waiting thread.
+	static void Wait(const std::atomic<uint32_t>& counter);
+
+	// Jobs waiting in the pool, not counting the ones being executed
+	static size_t GetQueueDepth();
+
 private:
 	static void Poll();
+	static void Enqueue(const std::function<void()>& job);
 };
 
@@ -0,0 +1,67 @@
+#include "MemoryBudget.h"
+
+#include "Metrics.h"
+
+std::array<std::atomic<int64_t>, static_cast<size_t>(MemoryCategory::Count)> MemoryBudget::_bytes{};
+std::atomic<uint64_t> MemoryBudget::_limit{ 0 };
+
+void MemoryBudget::Add(MemoryCategory category, int64_t bytes)
+{
+	_bytes[static_cast<size_t>(category)].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void MemoryBudget::Set(MemoryCategory category, int64_t bytes)
+{
+	_bytes[static_cast<size_t>(category)].store(bytes, std::memory_order_relaxed);
+}
+
+uint64_t MemoryBudget::GetBytes(MemoryCategory category)
+{
+	// Frees can land before the matching allocation is counted on another thread
+	int64_t bytes = _bytes[static_cast<size_t>(category)].load(std::memory_order_relaxed);
+	return bytes > 0 ? static_cast<uint64_t>(bytes) : 0;
+}
+
+uint64_t MemoryBudget::GetTotalBytes()
+{
+	uint64_t total = 0;
+	for (size_t i = 0; i < static_cast<size_t>(MemoryCategory::Count); i++)
+	{
+		total += GetBytes(static_cast<MemoryCategory>(i));
+	}
+	return total;
+}
+
+void MemoryBudget::SetLimit(uint64_t bytes)
+{
+	_limit.store(bytes, std::memory_order_relaxed);
+}
+
+uint64_t MemoryBudget::GetLimit()
+{
+	return _limit.load(std::memory_order_relaxed);
+}
+
+uint64_t MemoryBudget::GetExcess()
+{
+	uint64_t limit = GetLimit();
+	uint64_t total = GetTotalBytes();
+	return limit != 0 && total > limit ? total - limit : 0;
+}
+
+void MemoryBudget::PublishMetrics()
+{
+	static Metrics::Gauge& blockData = Metrics::GetGauge("memory.blockDataBytes");
+	static Metrics::Gauge& cpuMeshes = Metrics::GetGauge("memory.cpuMeshBytes");
+	static Metrics::Gauge& gpuBuffers = Metrics::GetGauge("memory.gpuBufferBytes");
+	static Metrics::Gauge& queuedJobs = Metrics::GetGauge("memory.queuedJobBytes");
+	static Metrics::Gauge& total = Metrics::GetGauge("memory.totalBytes");
+	static Metrics::Gauge& limit = Metrics::GetGauge("memory.limitBytes");
+
+	blockData.Set(GetBytes(MemoryCategory::BlockData));
+	cpuMeshes.Set(GetBytes(MemoryCategory::CpuMeshes));
+	gpuBuffers.Set(GetBytes(MemoryCategory::GpuBuffers));
+	queuedJobs.Set(GetBytes(MemoryCategory::QueuedJobs));
+	total.Set(GetTotalBytes());
+	limit.Set(GetLimit());
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+enum class MemoryCategory
+{
+	// Blocks of every chunk out of the pool, resident or held by a job, save or edit
+	BlockData,
+	// ChunkMesh vertex and index vectors kept in memory
+	CpuMeshes,
+	// Mesh data last uploaded for each chunk
+	GpuBuffers,
+	// Flattened blocks waiting on queued loads and saves
+	QueuedJobs,
+	Count
+};
+
+/**
+ * Process-wide byte counts for the memory chunks take, by category, and the limit World keeps the total under.
+ * Counts are relaxed atomics adjusted wherever the memory is allocated or freed, so safe from any thread.
+ *
+ * World checks GetExcess once a frame and, while it's above zero, drops what is cheapest to rebuild first: CPU mesh
+ * copies, then meshes of chunks that aren't drawn, then the farthest chunks outside the render distance.
+ */
+class MemoryBudget
+{
+private:
+	static std::array<std::atomic<int64_t>, static_cast<size_t>(MemoryCategory::Count)> _bytes;
+	static std::atomic<uint64_t> _limit;
+
+public:
+	static void Add(MemoryCategory category, int64_t bytes);
+	static void Set(MemoryCategory category, int64_t bytes);
+	static uint64_t GetBytes(MemoryCategory category);
+	static uint64_t GetTotalBytes();
+
+	// 0 means no limit
+	static void SetLimit(uint64_t bytes);
+	static uint64_t GetLimit();
+	// How far the total is over the limit, 0 when it isn't
+	static uint64_t GetExcess();
+
+	// memory.* gauges
+	static void PublishMetrics();
+};
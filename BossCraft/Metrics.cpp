@@ -0,0 +1,255 @@
+#include "Metrics.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+namespace
+{
+	size_t BucketIndex(uint64_t value)
+	{
+		size_t index = 0;
+		while (value != 0)
+		{
+			value >>= 1;
+			index++;
+		}
+		return index;
+	}
+
+	uint64_t BucketUpperBound(size_t index)
+	{
+		if (index >= 64)
+		{
+			return std::numeric_limits<uint64_t>::max();
+		}
+		return (uint64_t(1) << index) - 1;
+	}
+}
+
+void Metrics::Histogram::Record(uint64_t value)
+{
+	_buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+	_count.fetch_add(1, std::memory_order_relaxed);
+	_sum.fetch_add(value, std::memory_order_relaxed);
+
+	uint64_t max = _max.load(std::memory_order_relaxed);
+	while (value > max && !_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+	{
+	}
+}
+
+uint64_t Metrics::Histogram::GetCount() const
+{
+	return _count.load(std::memory_order_relaxed);
+}
+
+double Metrics::Histogram::GetMean() const
+{
+	uint64_t count = GetCount();
+	return count == 0 ? 0.0 : static_cast<double>(_sum.load(std::memory_order_relaxed)) / count;
+}
+
+uint64_t Metrics::Histogram::GetMax() const
+{
+	return _max.load(std::memory_order_relaxed);
+}
+
+uint64_t Metrics::Histogram::GetPercentile(double percentile) const
+{
+	uint64_t count = GetCount();
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(percentile * count + 0.5));
+	uint64_t seen = 0;
+	for (size_t i = 0; i < BucketCount; i++)
+	{
+		seen += _buckets[i].load(std::memory_order_relaxed);
+		if (seen >= target)
+		{
+			return std::min(BucketUpperBound(i), GetMax());
+		}
+	}
+	return GetMax();
+}
+
+void Metrics::Histogram::Reset()
+{
+	for (auto& bucket : _buckets)
+	{
+		bucket.store(0, std::memory_order_relaxed);
+	}
+	_count.store(0, std::memory_order_relaxed);
+	_sum.store(0, std::memory_order_relaxed);
+	_max.store(0, std::memory_order_relaxed);
+}
+
+Metrics::Registry& Metrics::GetRegistry()
+{
+	// Function-local so metrics can be looked up from any static initializer
+	static Registry registry;
+	return registry;
+}
+
+Metrics::Counter& Metrics::GetCounter(const std::string& name)
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	std::unique_ptr<Counter>& counter = registry.counters[name];
+	if (!counter)
+	{
+		counter.reset(new Counter());
+	}
+	return *counter;
+}
+
+Metrics::Gauge& Metrics::GetGauge(const std::string& name)
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	std::unique_ptr<Gauge>& gauge = registry.gauges[name];
+	if (!gauge)
+	{
+		gauge.reset(new Gauge());
+	}
+	return *gauge;
+}
+
+Metrics::Histogram& Metrics::GetHistogram(const std::string& name)
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	std::unique_ptr<Histogram>& histogram = registry.histograms[name];
+	if (!histogram)
+	{
+		histogram.reset(new Histogram());
+	}
+	return *histogram;
+}
+
+void Metrics::Reset()
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	for (auto& counter : registry.counters)
+	{
+		counter.second->Reset();
+	}
+	for (auto& histogram : registry.histograms)
+	{
+		histogram.second->Reset();
+	}
+}
+
+std::string Metrics::FormatLine()
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	std::stringstream line;
+	line << "metrics";
+	for (auto& counter : registry.counters)
+	{
+		line << ' ' << counter.first << '=' << counter.second->Get();
+	}
+	for (auto& gauge : registry.gauges)
+	{
+		line << ' ' << gauge.first << '=' << gauge.second->Get();
+	}
+	for (auto& histogram : registry.histograms)
+	{
+		const Histogram& h = *histogram.second;
+		line << ' ' << histogram.first << ".count=" << h.GetCount()
+			<< ' ' << histogram.first << ".mean=" << h.GetMean()
+			<< ' ' << histogram.first << ".p50=" << h.GetPercentile(0.50)
+			<< ' ' << histogram.first << ".p99=" << h.GetPercentile(0.99)
+			<< ' ' << histogram.first << ".max=" << h.GetMax();
+	}
+	return line.str();
+}
+
+bool Metrics::WriteJson(const std::string& path)
+{
+	Registry& registry = GetRegistry();
+	std::ofstream out(path);
+	if (!out.is_open())
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	out << "{\n  \"counters\": {";
+	const char* separator = "\n";
+	for (auto& counter : registry.counters)
+	{
+		out << separator << "    \"" << counter.first << "\": " << counter.second->Get();
+		separator = ",\n";
+	}
+	out << "\n  },\n  \"gauges\": {";
+	separator = "\n";
+	for (auto& gauge : registry.gauges)
+	{
+		out << separator << "    \"" << gauge.first << "\": " << gauge.second->Get();
+		separator = ",\n";
+	}
+	out << "\n  },\n  \"histograms\": {";
+	separator = "\n";
+	for (auto& histogram : registry.histograms)
+	{
+		const Histogram& h = *histogram.second;
+		out << separator << "    \"" << histogram.first << "\": { "
+			<< "\"count\": " << h.GetCount()
+			<< ", \"mean\": " << h.GetMean()
+			<< ", \"p50\": " << h.GetPercentile(0.50)
+			<< ", \"p99\": " << h.GetPercentile(0.99)
+			<< ", \"max\": " << h.GetMax() << " }";
+		separator = ",\n";
+	}
+	out << "\n  }\n}\n";
+	return out.good();
+}
+
+void Metrics::SetReportInterval(float intervalSeconds, const std::string& path)
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.reportInterval = intervalSeconds;
+	registry.timeSinceReport = 0.0f;
+	registry.reportPath = path;
+}
+
+void Metrics::Update(float dt)
+{
+	Registry& registry = GetRegistry();
+	std::string path;
+	{
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		if (registry.reportInterval <= 0.0f)
+		{
+			return;
+		}
+		registry.timeSinceReport += dt;
+		if (registry.timeSinceReport < registry.reportInterval)
+		{
+			return;
+		}
+		registry.timeSinceReport = 0.0f;
+		path = registry.reportPath;
+	}
+
+	std::string line = FormatLine();
+	if (path.empty())
+	{
+		std::cout << line << std::endl;
+	}
+	else
+	{
+		std::ofstream out(path, std::ios::app);
+		out << line << '\n';
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/**
+ * Named counters, gauges and histograms for the streaming pipeline. Look a metric up once (lookups take a lock)
+ * and keep the reference; updating it afterwards is a relaxed atomic and safe from any thread.
+ *
+ * Names are dotted, grouped by owner ("world.", "jobs.", "io.") and carry their unit as a suffix where it isn't a count.
+ */
+class Metrics
+{
+public:
+	class Counter
+	{
+	private:
+		std::atomic<uint64_t> _value{ 0 };
+
+	public:
+		void Add(uint64_t amount = 1) { _value.fetch_add(amount, std::memory_order_relaxed); }
+		uint64_t Get() const { return _value.load(std::memory_order_relaxed); }
+		void Reset() { _value.store(0, std::memory_order_relaxed); }
+	};
+
+	class Gauge
+	{
+	private:
+		std::atomic<int64_t> _value{ 0 };
+
+	public:
+		void Set(int64_t value) { _value.store(value, std::memory_order_relaxed); }
+		int64_t Get() const { return _value.load(std::memory_order_relaxed); }
+	};
+
+	// Power-of-two buckets: bucket N holds values in [2^(N-1), 2^N), so percentiles are upper bounds within 2x
+	class Histogram
+	{
+	public:
+		static const size_t BucketCount = 65;
+
+	private:
+		std::atomic<uint64_t> _buckets[BucketCount]{};
+		std::atomic<uint64_t> _count{ 0 };
+		std::atomic<uint64_t> _sum{ 0 };
+		std::atomic<uint64_t> _max{ 0 };
+
+	public:
+		void Record(uint64_t value);
+		uint64_t GetCount() const;
+		double GetMean() const;
+		uint64_t GetMax() const;
+		uint64_t GetPercentile(double percentile) const;
+		void Reset();
+	};
+
+private:
+	struct Registry
+	{
+		std::mutex mutex;
+		std::map<std::string, std::unique_ptr<Counter>> counters;
+		std::map<std::string, std::unique_ptr<Gauge>> gauges;
+		std::map<std::string, std::unique_ptr<Histogram>> histograms;
+
+		float reportInterval = 0.0f;
+		float timeSinceReport = 0.0f;
+		std::string reportPath;
+	};
+
+public:
+	static Counter& GetCounter(const std::string& name);
+	static Gauge& GetGauge(const std::string& name);
+	static Histogram& GetHistogram(const std::string& name);
+
+	// Zeroes counters and histograms; gauges keep their last value
+	static void Reset();
+
+	// Every metric as "name=value" pairs on a single line; histograms expand to count/mean/p50/p99/max
+	static std::string FormatLine();
+	static bool WriteJson(const std::string& path);
+
+	// Emit FormatLine every intervalSeconds from Update, to stdout or appended to path. Zero disables reporting.
+	static void SetReportInterval(float intervalSeconds, const std::string& path = "");
+	static void Update(float dt);
+
+private:
+	static Registry& GetRegistry();
+};
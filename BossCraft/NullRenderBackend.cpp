@@ -0,0 +1,68 @@
+#include "NullRenderBackend.h"
+
+NullRenderBackend::NullRenderBackend() : _stats(), _nextHandle(1)
+{
+}
+
+const RenderStats& NullRenderBackend::GetStats()
+{
+	return _stats;
+}
+
+void NullRenderBackend::ResetStats()
+{
+	// Still in the buffers, so not part of the reset
+	uint64_t bytesResident = _stats.bytesResident;
+	_stats = RenderStats();
+	_stats.bytesResident = bytesResident;
+}
+
+void NullRenderBackend::SetProjection(const glm::mat4& projection)
+{
+}
+
+void NullRenderBackend::BeginFrame(const glm::mat4& view)
+{
+	_stats.frames++;
+}
+
+ChunkRenderHandle NullRenderBackend::CreateChunkBuffers()
+{
+	_stats.buffersCreated++;
+	// Hand out distinct non-zero names so handle bookkeeping behaves like GL's
+	ChunkRenderHandle handle{ _nextHandle, _nextHandle + 1, _nextHandle + 2 };
+	_nextHandle += 3;
+	return handle;
+}
+
+void NullRenderBackend::UploadChunkMesh(const ChunkRenderHandle& handle, const uint32_t* vertexData, size_t vertexCount,
+	const uint16_t* indexData, size_t indexCount)
+{
+	size_t bytes = vertexCount * sizeof(uint32_t) + indexCount * sizeof(uint16_t);
+	_stats.uploads++;
+	_stats.bytesUploaded += bytes;
+	size_t& resident = _residentBytes[handle.VAO];
+	_stats.bytesResident += bytes - resident;
+	resident = bytes;
+}
+
+void NullRenderBackend::DrawChunk(const ChunkRenderHandle& handle, const glm::mat4& model, unsigned int indexCount)
+{
+	_stats.draws++;
+	_stats.indicesDrawn += indexCount;
+}
+
+void NullRenderBackend::DestroyChunkBuffers(const ChunkRenderHandle& handle)
+{
+	// Chunks that never reached the main thread have nothing to free
+	if (handle.VAO != 0)
+	{
+		_stats.buffersDestroyed++;
+		auto resident = _residentBytes.find(handle.VAO);
+		if (resident != _residentBytes.end())
+		{
+			_stats.bytesResident -= resident->second;
+			_residentBytes.erase(resident);
+		}
+	}
+}
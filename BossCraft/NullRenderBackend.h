@@ -0,0 +1,44 @@
+#pragma once
+#include <unordered_map>
+
+#include "IRenderBackend.h"
+
+struct RenderStats
+{
+	uint64_t frames;
+	uint64_t buffersCreated;
+	uint64_t buffersDestroyed;
+	uint64_t uploads;
+	uint64_t bytesUploaded;
+	// Bytes last uploaded to buffers that haven't been destroyed
+	uint64_t bytesResident;
+	uint64_t draws;
+	uint64_t indicesDrawn;
+};
+
+/**
+ * Backend for headless runs: no GPU calls, just records what would have been submitted.
+ */
+class NullRenderBackend : public IRenderBackend
+{
+private:
+	RenderStats _stats;
+	unsigned int _nextHandle;
+	// By VAO
+	std::unordered_map<unsigned int, size_t> _residentBytes;
+
+public:
+	NullRenderBackend();
+
+	const RenderStats& GetStats();
+	void ResetStats();
+
+	void SetProjection(const glm::mat4& projection) override;
+	void BeginFrame(const glm::mat4& view) override;
+
+	ChunkRenderHandle CreateChunkBuffers() override;
+	void UploadChunkMesh(const ChunkRenderHandle& handle, const uint32_t* vertexData, size_t vertexCount,
+		const uint16_t* indexData, size_t indexCount) override;
+	void DrawChunk(const ChunkRenderHandle& handle, const glm::mat4& model, unsigned int indexCount) override;
+	void DestroyChunkBuffers(const ChunkRenderHandle& handle) override;
+};
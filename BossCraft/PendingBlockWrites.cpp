@@ -0,0 +1,120 @@
+#include "PendingBlockWrites.h"
+
+#include "Chunk.h"
+#include "Metrics.h"
+
+PendingBlockWrites::~PendingBlockWrites()
+{
+	Batch* batch = _head.exchange(nullptr);
+	while (batch != nullptr)
+	{
+		Batch* next = batch->next;
+		delete batch;
+		batch = next;
+	}
+}
+
+void PendingBlockWrites::Push(glm::ivec2 chunkPos, std::vector<Write>&& writes)
+{
+	static Metrics::Counter& pushed = Metrics::GetCounter("world.pendingWrites.pushed");
+
+	if (writes.empty())
+	{
+		return;
+	}
+	pushed.Add(writes.size());
+
+	Batch* batch = new Batch{ chunkPos, std::move(writes), _head.load(std::memory_order_relaxed) };
+	while (!_head.compare_exchange_weak(batch->next, batch, std::memory_order_release, std::memory_order_relaxed))
+	{
+	}
+}
+
+std::vector<glm::ivec2> PendingBlockWrites::Drain()
+{
+	Batch* batch = _head.exchange(nullptr, std::memory_order_acquire);
+
+	// The stack hands batches back newest first; reverse so writes land in the order they were pushed
+	Batch* ordered = nullptr;
+	while (batch != nullptr)
+	{
+		Batch* next = batch->next;
+		batch->next = ordered;
+		ordered = batch;
+		batch = next;
+	}
+
+	std::vector<glm::ivec2> targets;
+	while (ordered != nullptr)
+	{
+		std::vector<Write>& writes = _pending[ordered->chunkPos];
+		writes.insert(writes.end(), ordered->writes.begin(), ordered->writes.end());
+		targets.emplace_back(ordered->chunkPos);
+
+		Batch* next = ordered->next;
+		delete ordered;
+		ordered = next;
+	}
+	return targets;
+}
+
+bool PendingBlockWrites::Apply(glm::ivec2 chunkPos, Chunk* chunk)
+{
+	static Metrics::Counter& applied = Metrics::GetCounter("world.pendingWrites.applied");
+
+	auto it = _pending.find(chunkPos);
+	if (it == _pending.end())
+	{
+		return false;
+	}
+
+	ApplyTo(chunk, it->second);
+	applied.Add(it->second.size());
+	_pending.erase(it);
+	return true;
+}
+
+void PendingBlockWrites::ApplyTo(Chunk* chunk, const std::vector<Write>& writes)
+{
+	for (const Write& write : writes)
+	{
+		glm::ivec3 pos(write.localPos);
+		if (write.replaceSolid || chunk->GetDataAtPosition(pos) == 0)
+		{
+			chunk->SetData(pos, write.block);
+		}
+	}
+}
+
+std::vector<std::pair<glm::ivec2, std::vector<PendingBlockWrites::Write>>> PendingBlockWrites::TakeOutside(glm::ivec2 center, int radius)
+{
+	std::vector<std::pair<glm::ivec2, std::vector<Write>>> taken;
+	for (auto it = _pending.begin(); it != _pending.end();)
+	{
+		glm::ivec2 offset = glm::abs(it->first - center);
+		if (offset.x <= radius && offset.y <= radius)
+		{
+			++it;
+			continue;
+		}
+		taken.emplace_back(it->first, std::move(it->second));
+		it = _pending.erase(it);
+	}
+	return taken;
+}
+
+bool PendingBlockWrites::Has(glm::ivec2 chunkPos)
+{
+	return _pending.find(chunkPos) != _pending.end();
+}
+
+const std::vector<PendingBlockWrites::Write>* PendingBlockWrites::Find(glm::ivec2 chunkPos)
+{
+	auto it = _pending.find(chunkPos);
+	return it != _pending.end() ? &it->second : NULL;
+}
+
+size_t PendingBlockWrites::GetPendingChunkCount()
+{
+	return _pending.size();
+}
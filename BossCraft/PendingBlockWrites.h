@@ -0,0 +1,59 @@
+#pragma once
+#define GLM_ENABLE_EXPERIMENTAL
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "glm/gtx/hash.hpp"
+
+class Chunk;
+
+/**
+ * Block writes aimed at chunks that may not exist yet, e.g. leaves of a tree rooted in a neighbour. Generation jobs push
+ * batches from any thread without locking; the main thread drains them once per frame and applies each chunk's writes
+ * when that chunk arrives from generation or disk (or straight away if it is already resident). Writes for chunks that
+ * leave the world's window are taken out with TakeOutside, so only the window's worth is ever held.
+ */
+class PendingBlockWrites
+{
+public:
+	struct Write
+	{
+		glm::u8vec3 localPos;
+		uint8_t block;
+		// Leaves only fill air, logs overwrite whatever is there
+		bool replaceSolid;
+	};
+
+private:
+	struct Batch
+	{
+		glm::ivec2 chunkPos;
+		std::vector<Write> writes;
+		Batch* next;
+	};
+
+	std::atomic<Batch*> _head{ nullptr };
+	std::unordered_map<glm::ivec2, std::vector<Write>> _pending;
+
+public:
+	~PendingBlockWrites();
+
+	// Any thread
+	void Push(glm::ivec2 chunkPos, std::vector<Write>&& writes);
+
+	// Main thread only. Returns the chunks that received writes since the last drain.
+	std::vector<glm::ivec2> Drain();
+
+	// Main thread only. Applies and forgets every write for the chunk; false if there were none.
+	bool Apply(glm::ivec2 chunkPos, Chunk* chunk);
+	// Any thread, for a chunk nothing else is touching
+	static void ApplyTo(Chunk* chunk, const std::vector<Write>& writes);
+	// Main thread only. Removes and returns the writes for chunks more than radius chunks from center along x or z.
+	std::vector<std::pair<glm::ivec2, std::vector<Write>>> TakeOutside(glm::ivec2 center, int radius);
+	bool Has(glm::ivec2 chunkPos);
+	// Main thread only. The writes waiting for the chunk, or NULL; valid until the next Drain or Apply.
+	const std::vector<Write>* Find(glm::ivec2 chunkPos);
+	size_t GetPendingChunkCount();
+};
@@ -1,7 +1,9 @@
 #include "Physics.h"
 
 #include <algorithm>
+#include <limits>
 
+#include "BlockAccessor.h"
 #include "World.h"
 
 bool Physics::RayCast(glm::vec3 rayPos, glm::vec3 rayDir, RayCastHit& hit, float dist, World* world)
@@ -32,9 +34,10 @@ bool Physics::RayCast(glm::vec3 rayPos, glm::vec3 rayDir, RayCastHit& hit, float
 
     if (rayDir.x == 0)
     {
+        // Never crosses a boundary on this axis
         step.x = 0;
-        deltaDist.x = rayDir.x;
-        sideDist.x = (rayPos.x - roundedRayPos.x) * deltaDist.x;
+        deltaDist.x = std::numeric_limits<float>::infinity();
+        sideDist.x = std::numeric_limits<float>::infinity();
     }
     else if (rayDir.x > 0)
     {
@@ -51,9 +54,10 @@ bool Physics::RayCast(glm::vec3 rayPos, glm::vec3 rayDir, RayCastHit& hit, float
 
     if (rayDir.y == 0)
     {
+        // Never crosses a boundary on this axis
         step.y = 0;
-        deltaDist.y = rayDir.y;
-        sideDist.y = (rayPos.y - roundedRayPos.y) * deltaDist.y;
+        deltaDist.y = std::numeric_limits<float>::infinity();
+        sideDist.y = std::numeric_limits<float>::infinity();
     }
     else if (rayDir.y > 0)
     {
@@ -70,9 +74,10 @@ bool Physics::RayCast(glm::vec3 rayPos, glm::vec3 rayDir, RayCastHit& hit, float
 
     if (rayDir.z == 0)
     {
+        // Never crosses a boundary on this axis
         step.z = 0;
-        deltaDist.z = rayDir.z;
-        sideDist.z = (rayPos.z - roundedRayPos.z) * deltaDist.z;
+        deltaDist.z = std::numeric_limits<float>::infinity();
+        sideDist.z = std::numeric_limits<float>::infinity();
     }
     else if (rayDir.z > 0)
     {
@@ -87,6 +92,8 @@ bool Physics::RayCast(glm::vec3 rayPos, glm::vec3 rayDir, RayCastHit& hit, float
         sideDist.z = (rayPos.z - roundedRayPos.z) * deltaDist.z;
     }
 
+    // Consecutive steps almost always stay in the same chunk
+    BlockAccessor blocks(world);
     do
     {
         glm::ivec3 normal;
@@ -137,7 +144,7 @@ bool Physics::RayCast(glm::vec3 rayPos, glm::vec3 rayDir, RayCastHit& hit, float
             }
         }
 
-        if (world->GetBlockAtAbsPos(roundedRayPos) != 0)
+        if (blocks.GetBlock(roundedRayPos) != 0)
         {
             hit =
             RayCastHit{
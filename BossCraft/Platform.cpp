@@ -0,0 +1,73 @@
+#include "Platform.h"
+
+#include <filesystem>
+#include <system_error>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <intrin.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+bool Platform::EnsureDirectory(const std::string& path)
+{
+	std::error_code err;
+	std::filesystem::create_directories(path, err);
+	return std::filesystem::is_directory(path, err);
+}
+
+bool Platform::SetThreadAffinity(std::thread& thread, unsigned int core)
+{
+#ifdef _WIN32
+	HANDLE handle = (HANDLE)thread.native_handle();
+	DWORD_PTR affinityMask = 1ull << core;
+	return SetThreadAffinityMask(handle, affinityMask) != 0;
+#elif defined(__linux__)
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	CPU_SET(core, &cpuSet);
+	return pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpuSet) == 0;
+#else
+	return false;
+#endif
+}
+
+bool Platform::SetThreadName(std::thread& thread, const std::string& name)
+{
+#ifdef _WIN32
+	std::wstring wideName(name.begin(), name.end());
+	HRESULT hr = SetThreadDescription((HANDLE)thread.native_handle(), wideName.c_str());
+	return SUCCEEDED(hr);
+#elif defined(__linux__)
+	return pthread_setname_np(thread.native_handle(), name.substr(0, 15).c_str()) == 0;
+#else
+	return false;
+#endif
+}
+
+bool Platform::CpuSupportsAVX2()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+	{
+		return false;
+	}
+	__cpuid(info, 1);
+	bool osUsesXSave = (info[2] & (1 << 27)) != 0;
+	bool cpuHasAVX = (info[2] & (1 << 28)) != 0;
+	if (!osUsesXSave || !cpuHasAVX || (_xgetbv(0) & 0x6) != 0x6)
+	{
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	return __builtin_cpu_supports("avx2");
+#else
+	return false;
+#endif
+}
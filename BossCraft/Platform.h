@@ -0,0 +1,22 @@
+#pragma once
+#include <string>
+#include <thread>
+
+/**
+ * Thin wrapper over the OS specific bits (directories, thread setup) so the rest of the engine builds on Windows and Linux.
+ */
+class Platform
+{
+public:
+	// Creates the directory and any missing parents. Returns false if it does not exist afterwards.
+	static bool EnsureDirectory(const std::string& path);
+
+	// Pins the thread to a single logical core. Returns false if the OS refused.
+	static bool SetThreadAffinity(std::thread& thread, unsigned int core);
+
+	// Names the thread for debuggers and profilers. Linux truncates names to 15 characters.
+	static bool SetThreadName(std::thread& thread, const std::string& name);
+
+	// True if the CPU and OS both support AVX2, so code built with an AVX2 target attribute can run.
+	static bool CpuSupportsAVX2();
+};
@@ -6,8 +6,8 @@
 Player::Player(glm::vec3 pos) : _worldPos(pos)
 {
 	_camera = new Camera(pos);
-    _nextAllowedLeftClick = std::chrono::high_resolution_clock::now();
-    _nextAllowedRightClick = std::chrono::high_resolution_clock::now();
+    _nextAllowedLeftClick = std::chrono::steady_clock::now();
+    _nextAllowedRightClick = std::chrono::steady_clock::now();
 }
 
 void Player::ProcessKeyBoard(CameraDirection direction, float velocity, float dt)
@@ -41,7 +41,7 @@ void Player::ProcessLeftMouseClick()
 {
     if (_world == NULL) return;
 
-    auto now = std::chrono::high_resolution_clock::now();
+    auto now = std::chrono::steady_clock::now();
     if (now < _nextAllowedLeftClick) return;
 
     glm::ivec3 blockToBreak;
@@ -63,7 +63,7 @@ void Player::ProcessRightMouseClick()
 {
     if (_world == NULL) return;
 
-    auto now = std::chrono::high_resolution_clock::now();
+    auto now = std::chrono::steady_clock::now();
     if (now < _nextAllowedRightClick) return;
 	
     RayCastHit hit;
@@ -0,0 +1,148 @@
+#include "Profiler.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+
+std::atomic<bool> Profiler::_capturing;
+std::atomic<uint32_t> Profiler::_captureId;
+std::vector<Profiler::ThreadBuffer*> Profiler::_threads;
+std::mutex Profiler::_threadsMutex;
+
+void Profiler::BeginCapture()
+{
+	_captureId.fetch_add(1);
+	_capturing.store(true);
+}
+
+void Profiler::EndCapture()
+{
+	_capturing.store(false);
+}
+
+bool Profiler::IsCapturing()
+{
+	return _capturing.load(std::memory_order_relaxed);
+}
+
+void Profiler::SetThreadName(const std::string& name)
+{
+	ThreadBuffer* buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(_threadsMutex);
+	buffer->threadName = name;
+}
+
+uint64_t Profiler::NowNs()
+{
+	static const auto epoch = std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Profiler::Record(const char* name, uint64_t startNs, uint64_t endNs)
+{
+	if (!IsCapturing())
+	{
+		return;
+	}
+
+	ThreadBuffer* buffer = GetThreadBuffer();
+	uint32_t captureId = _captureId.load(std::memory_order_relaxed);
+	if (buffer->captureId.load(std::memory_order_relaxed) != captureId)
+	{
+		buffer->captureId.store(captureId, std::memory_order_relaxed);
+		buffer->count.store(0, std::memory_order_relaxed);
+		buffer->dropped.store(0, std::memory_order_relaxed);
+	}
+
+	size_t index = buffer->count.load(std::memory_order_relaxed);
+	if (index >= ThreadBuffer::Capacity)
+	{
+		buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	buffer->zones[index] = { name, startNs, endNs };
+	// Publish the zone to WriteChromeTrace
+	buffer->count.store(index + 1, std::memory_order_release);
+}
+
+Profiler::ThreadBuffer* Profiler::GetThreadBuffer()
+{
+	thread_local ThreadBuffer* buffer = nullptr;
+	if (buffer == nullptr)
+	{
+		// Buffers outlive their threads so a trace can still be written after a worker exits
+		buffer = new ThreadBuffer();
+		buffer->captureId = _captureId.load();
+		buffer->count.store(0);
+		buffer->dropped.store(0);
+
+		std::lock_guard<std::mutex> lock(_threadsMutex);
+		buffer->threadIndex = static_cast<uint32_t>(_threads.size());
+		buffer->threadName = "Thread_" + std::to_string(buffer->threadIndex);
+		_threads.emplace_back(buffer);
+	}
+	return buffer;
+}
+
+static void WriteJsonString(std::ofstream& out, const std::string& value)
+{
+	out << '"';
+	for (char c : value)
+	{
+		if (c == '"' || c == '\\')
+		{
+			out << '\\';
+		}
+		out << c;
+	}
+	out << '"';
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path)
+{
+	std::ofstream out(path);
+	if (!out.good())
+	{
+		return false;
+	}
+
+	uint32_t captureId = _captureId.load();
+	bool first = true;
+	out << std::fixed << std::setprecision(3);
+	out << "{\"traceEvents\":[\n";
+
+	std::lock_guard<std::mutex> lock(_threadsMutex);
+	for (ThreadBuffer* buffer : _threads)
+	{
+		out << (first ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->threadIndex
+			<< ",\"args\":{\"name\":";
+		WriteJsonString(out, buffer->threadName);
+		out << "}}";
+		first = false;
+
+		if (buffer->captureId.load() != captureId)
+		{
+			continue;
+		}
+
+		size_t count = buffer->count.load(std::memory_order_acquire);
+		for (size_t i = 0; i < count; i++)
+		{
+			const Zone& zone = buffer->zones[i];
+			out << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadIndex << ",\"name\":";
+			WriteJsonString(out, zone.name);
+			// Trace timestamps are microseconds
+			out << ",\"ts\":" << zone.startNs / 1000.0 << ",\"dur\":" << (zone.endNs - zone.startNs) / 1000.0 << "}";
+		}
+
+		uint64_t dropped = buffer->dropped.load();
+		if (dropped > 0)
+		{
+			out << ",\n{\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":" << buffer->threadIndex
+				<< ",\"name\":\"zones dropped\",\"ts\":0,\"args\":{\"count\":" << dropped << "}}";
+		}
+	}
+
+	out << "\n]}\n";
+	return out.good();
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Scoped-zone frame profiler. Each thread records into its own fixed-size buffer with no locks on the hot path;
+ * WriteChromeTrace dumps every thread's zones for chrome://tracing or Perfetto.
+ *
+ * Zones only exist when BOSSCRAFT_PROFILE is defined (Debug builds, or BOSSCRAFT_ENABLE_PROFILER in CMake);
+ * otherwise the macros compile to nothing.
+ */
+class Profiler
+{
+public:
+	struct Zone
+	{
+		const char* name;
+		uint64_t startNs;
+		uint64_t endNs;
+	};
+
+	struct ThreadBuffer
+	{
+		static const size_t Capacity = 1 << 16;
+
+		std::string threadName;
+		uint32_t threadIndex;
+		// Capture this buffer's contents belong to; the owning thread resets itself when a new capture starts
+		std::atomic<uint32_t> captureId;
+		std::atomic<size_t> count;
+		std::atomic<uint64_t> dropped;
+		Zone zones[Capacity];
+	};
+
+private:
+	static std::atomic<bool> _capturing;
+	static std::atomic<uint32_t> _captureId;
+	static std::vector<ThreadBuffer*> _threads;
+	static std::mutex _threadsMutex;
+
+public:
+	// Drops anything recorded so far and starts recording
+	static void BeginCapture();
+	static void EndCapture();
+	static bool IsCapturing();
+
+	static void SetThreadName(const std::string& name);
+	static uint64_t NowNs();
+	static void Record(const char* name, uint64_t startNs, uint64_t endNs);
+
+	// Chrome trace event format. Returns false if the file could not be written.
+	static bool WriteChromeTrace(const std::string& path);
+
+private:
+	static ThreadBuffer* GetThreadBuffer();
+};
+
+class ProfileZone
+{
+private:
+	const char* _name;
+	uint64_t _startNs;
+
+public:
+	ProfileZone(const char* name) : _name(name), _startNs(Profiler::NowNs())
+	{
+	}
+
+	~ProfileZone()
+	{
+		Profiler::Record(_name, _startNs, Profiler::NowNs());
+	}
+};
+
+#ifdef BOSSCRAFT_PROFILE
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileZone PROFILE_CONCAT(_profileZone, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#define PROFILE_THREAD_NAME(name) Profiler::SetThreadName(name)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_THREAD_NAME(name)
+#endif
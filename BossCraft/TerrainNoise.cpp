@@ -0,0 +1,211 @@
+#include "TerrainNoise.h"
+
+#include "Platform.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BOSSCRAFT_NOISE_AVX2 1
+#include <immintrin.h>
+#endif
+
+#if defined(BOSSCRAFT_NOISE_AVX2) && (defined(__GNUC__) || defined(__clang__))
+#define BOSSCRAFT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define BOSSCRAFT_TARGET_AVX2
+#endif
+
+namespace
+{
+	// Mirrors FastNoiseLite's private constants and gradient table; the kernel below has to hash and round the same way
+	const int PrimeX = 501125321;
+	const int PrimeY = 1136930381;
+	const int HashMultiplier = 0x27d4eb2d;
+
+	const float SQRT3 = 1.7320508075688772935274463415059f;
+	const float F2 = 0.5f * (SQRT3 - 1);
+	const float G2 = (3 - SQRT3) / 6;
+
+	// 24 directions repeated five times, then 8 diagonals, as in FastNoiseLite::Lookup::Gradients2D
+	const float BaseGradients[48] = {
+		0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+		0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+		0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+		-0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+		-0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+		-0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+	};
+	const float DiagonalGradients[16] = {
+		0.38268343236509f, 0.923879532511287f, 0.923879532511287f, 0.38268343236509f, 0.923879532511287f, -0.38268343236509f, 0.38268343236509f, -0.923879532511287f,
+		-0.38268343236509f, -0.923879532511287f, -0.923879532511287f, -0.38268343236509f, -0.923879532511287f, 0.38268343236509f, -0.38268343236509f, 0.923879532511287f,
+	};
+
+	struct GradientTable
+	{
+		float values[256];
+
+		GradientTable()
+		{
+			for (unsigned int i = 0; i < 240; i++)
+			{
+				values[i] = BaseGradients[i % 48];
+			}
+			for (unsigned int i = 0; i < 16; i++)
+			{
+				values[240 + i] = DiagonalGradients[i];
+			}
+		}
+	};
+
+	const GradientTable Gradients;
+
+#ifdef BOSSCRAFT_NOISE_AVX2
+	BOSSCRAFT_TARGET_AVX2 __m256i FastFloor(__m256 f)
+	{
+		// Truncate, then step negative values down by one (the mask is -1 in those lanes)
+		__m256i truncated = _mm256_cvttps_epi32(f);
+		__m256i negative = _mm256_castps_si256(_mm256_cmp_ps(f, _mm256_setzero_ps(), _CMP_LT_OQ));
+		return _mm256_add_epi32(truncated, negative);
+	}
+
+	BOSSCRAFT_TARGET_AVX2 __m256 GradCoord(__m256i seed, __m256i xPrimed, __m256i yPrimed, __m256 xd, __m256 yd)
+	{
+		__m256i hash = _mm256_xor_si256(seed, _mm256_xor_si256(xPrimed, yPrimed));
+		hash = _mm256_mullo_epi32(hash, _mm256_set1_epi32(HashMultiplier));
+		hash = _mm256_xor_si256(hash, _mm256_srai_epi32(hash, 15));
+		hash = _mm256_and_si256(hash, _mm256_set1_epi32(127 << 1));
+
+		__m256 xg = _mm256_i32gather_ps(Gradients.values, hash, 4);
+		__m256 yg = _mm256_i32gather_ps(Gradients.values, _mm256_or_si256(hash, _mm256_set1_epi32(1)), 4);
+		return _mm256_add_ps(_mm256_mul_ps(xd, xg), _mm256_mul_ps(yd, yg));
+	}
+
+	// Zero where the falloff is not positive, otherwise falloff^4 * gradient
+	BOSSCRAFT_TARGET_AVX2 __m256 Contribution(__m256 falloff, __m256 gradient)
+	{
+		__m256 squared = _mm256_mul_ps(falloff, falloff);
+		__m256 value = _mm256_mul_ps(_mm256_mul_ps(squared, squared), gradient);
+		return _mm256_and_ps(value, _mm256_cmp_ps(falloff, _mm256_setzero_ps(), _CMP_GT_OQ));
+	}
+
+	// Same operations in the same order as FastNoiseLite::SingleSimplex after TransformNoiseCoordinate
+	BOSSCRAFT_TARGET_AVX2 __m256 SingleSimplex8(int seed, float frequency, __m256 x, __m256 y)
+	{
+		const float C1 = (float)(2 * (1 - 2 * G2) * (1 / G2 - 2));
+		const float C2 = (float)(-2 * (1 - 2 * G2) * (1 - 2 * G2));
+		const float Offset2 = 2 * (float)G2 - 1;
+
+		x = _mm256_mul_ps(x, _mm256_set1_ps(frequency));
+		y = _mm256_mul_ps(y, _mm256_set1_ps(frequency));
+		__m256 skew = _mm256_mul_ps(_mm256_add_ps(x, y), _mm256_set1_ps(F2));
+		x = _mm256_add_ps(x, skew);
+		y = _mm256_add_ps(y, skew);
+
+		__m256i i = FastFloor(x);
+		__m256i j = FastFloor(y);
+		__m256 xi = _mm256_sub_ps(x, _mm256_cvtepi32_ps(i));
+		__m256 yi = _mm256_sub_ps(y, _mm256_cvtepi32_ps(j));
+
+		__m256 t = _mm256_mul_ps(_mm256_add_ps(xi, yi), _mm256_set1_ps(G2));
+		__m256 x0 = _mm256_sub_ps(xi, t);
+		__m256 y0 = _mm256_sub_ps(yi, t);
+
+		i = _mm256_mullo_epi32(i, _mm256_set1_epi32(PrimeX));
+		j = _mm256_mullo_epi32(j, _mm256_set1_epi32(PrimeY));
+		__m256i iNext = _mm256_add_epi32(i, _mm256_set1_epi32(PrimeX));
+		__m256i jNext = _mm256_add_epi32(j, _mm256_set1_epi32(PrimeY));
+		__m256i seeds = _mm256_set1_epi32(seed);
+
+		__m256 half = _mm256_set1_ps(0.5f);
+		__m256 a = _mm256_sub_ps(_mm256_sub_ps(half, _mm256_mul_ps(x0, x0)), _mm256_mul_ps(y0, y0));
+		__m256 n0 = Contribution(a, GradCoord(seeds, i, j, x0, y0));
+
+		__m256 c = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(C1), t), _mm256_add_ps(_mm256_set1_ps(C2), a));
+		__m256 x2 = _mm256_add_ps(x0, _mm256_set1_ps(Offset2));
+		__m256 y2 = _mm256_add_ps(y0, _mm256_set1_ps(Offset2));
+		__m256 n2 = Contribution(c, GradCoord(seeds, iNext, jNext, x2, y2));
+
+		// Middle corner is (0,1) above the diagonal and (1,0) below it
+		__m256 upper = _mm256_cmp_ps(y0, x0, _CMP_GT_OQ);
+		__m256i upperInt = _mm256_castps_si256(upper);
+		__m256 x1 = _mm256_add_ps(x0, _mm256_blendv_ps(_mm256_set1_ps((float)G2 - 1), _mm256_set1_ps((float)G2), upper));
+		__m256 y1 = _mm256_add_ps(y0, _mm256_blendv_ps(_mm256_set1_ps((float)G2), _mm256_set1_ps((float)G2 - 1), upper));
+		__m256i i1 = _mm256_blendv_epi8(iNext, i, upperInt);
+		__m256i j1 = _mm256_blendv_epi8(j, jNext, upperInt);
+		__m256 b = _mm256_sub_ps(_mm256_sub_ps(half, _mm256_mul_ps(x1, x1)), _mm256_mul_ps(y1, y1));
+		__m256 n1 = Contribution(b, GradCoord(seeds, i1, j1, x1, y1));
+
+		__m256 sum = _mm256_add_ps(_mm256_add_ps(n0, n1), n2);
+		return _mm256_mul_ps(sum, _mm256_set1_ps(99.83685446303647f));
+	}
+#endif
+}
+
+TerrainNoise::TerrainNoise()
+{
+	_seed = 1337;
+	_frequency = 0.01f;
+	_noise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
+	_noise.SetSeed(_seed);
+	_noise.SetFrequency(_frequency);
+#ifdef BOSSCRAFT_NOISE_AVX2
+	_useAVX2 = Platform::CpuSupportsAVX2();
+#else
+	_useAVX2 = false;
+#endif
+}
+
+void TerrainNoise::SetSeed(int seed)
+{
+	_seed = seed;
+	_noise.SetSeed(seed);
+}
+
+void TerrainNoise::SetFrequency(float frequency)
+{
+	_frequency = frequency;
+	_noise.SetFrequency(frequency);
+}
+
+int TerrainNoise::GetSeed()
+{
+	return _seed;
+}
+
+float TerrainNoise::GetFrequency()
+{
+	return _frequency;
+}
+
+float TerrainNoise::GetNoise(float x, float z)
+{
+	return _noise.GetNoise(x, z);
+}
+
+void TerrainNoise::GetNoiseGrid(int originX, int originZ, unsigned int width, unsigned int depth, float* out)
+{
+	unsigned int vectorDepth = _useAVX2 ? depth - (depth % 8) : 0;
+	for (unsigned int x = 0; x < width; x++)
+	{
+		float* row = out + x * depth;
+		if (vectorDepth > 0)
+		{
+			GetNoiseRowAVX2(originX + static_cast<int>(x), originZ, vectorDepth, row);
+		}
+		for (unsigned int z = vectorDepth; z < depth; z++)
+		{
+			row[z] = _noise.GetNoise(static_cast<float>(originX + static_cast<int>(x)), static_cast<float>(originZ + static_cast<int>(z)));
+		}
+	}
+}
+
+BOSSCRAFT_TARGET_AVX2 void TerrainNoise::GetNoiseRowAVX2(int x, int originZ, unsigned int depth, float* out)
+{
+#ifdef BOSSCRAFT_NOISE_AVX2
+	__m256 xs = _mm256_set1_ps(static_cast<float>(x));
+	__m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	for (unsigned int z = 0; z < depth; z += 8)
+	{
+		__m256 zs = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(originZ + static_cast<int>(z)), lanes));
+		_mm256_storeu_ps(out + z, SingleSimplex8(_seed, _frequency, xs, zs));
+	}
+#endif
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <FastNoiseLite.h>
+
+/**
+ * 2D OpenSimplex2 terrain noise. GetNoise is the scalar FastNoiseLite call; GetNoiseGrid evaluates a whole grid of
+ * integer block columns at once, eight columns per AVX2 instruction when the CPU has it, and returns exactly what
+ * GetNoise would have for each column so saved worlds don't change with the code path.
+ */
+class TerrainNoise
+{
+private:
+	FastNoiseLite _noise;
+	int _seed;
+	float _frequency;
+	bool _useAVX2;
+
+public:
+	TerrainNoise();
+
+	void SetSeed(int seed);
+	void SetFrequency(float frequency);
+	int GetSeed();
+	float GetFrequency();
+
+	float GetNoise(float x, float z);
+
+	// Fills out[x * depth + z] with the noise at block column (originX + x, originZ + z)
+	void GetNoiseGrid(int originX, int originZ, unsigned int width, unsigned int depth, float* out);
+
+private:
+	void GetNoiseRowAVX2(int x, int originZ, unsigned int depth, float* out);
+};
@@ -0,0 +1,53 @@
+#include "ThreadPoolChunkIOBackend.h"
+
+#include <fstream>
+
+#include "Chunk.h"
+#include "Profiler.h"
+
+ThreadPoolChunkIOBackend::ThreadPoolChunkIOBackend(size_t numThreads) : _pool(numThreads)
+{
+}
+
+const char* ThreadPoolChunkIOBackend::GetName()
+{
+	return "threadpool";
+}
+
+void ThreadPoolChunkIOBackend::Submit(std::vector<ChunkIORequest>& batch)
+{
+	for (ChunkIORequest& request : batch)
+	{
+		_pool.Enqueue([request](unsigned int)
+			{
+				PROFILE_SCOPE(request.op == ChunkIOOp::Load ? "ChunkIO::Load" : "ChunkIO::Save");
+				bool success = false;
+				if (request.op == ChunkIOOp::Load)
+				{
+					std::ifstream inStream(request.path, std::ios::binary);
+					if (inStream.good())
+					{
+						inStream.read(reinterpret_cast<char*>(request.buffer.get()), CHUNK_VOLUME);
+						success = inStream.gcount() == CHUNK_VOLUME;
+					}
+				}
+				else
+				{
+					std::ofstream outStream(request.path, std::ios::binary);
+					if (outStream.good())
+					{
+						outStream.write(reinterpret_cast<char*>(request.buffer.get()), CHUNK_VOLUME);
+						// Errors writing out the buffered tail only show up on close
+						outStream.close();
+						success = !outStream.fail();
+					}
+				}
+
+				if (request.onComplete)
+				{
+					request.onComplete(request.chunk, success);
+				}
+			});
+	}
+	batch.clear();
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "IChunkIOBackend.h"
+#include "ThreadPool.h"
+
+/**
+ * Fallback backend: blocking file reads/writes on a small dedicated pool, kept apart from the JobSystem workers.
+ */
+class ThreadPoolChunkIOBackend : public IChunkIOBackend
+{
+private:
+	ThreadPool _pool;
+
+public:
+	ThreadPoolChunkIOBackend(size_t numThreads);
+
+	const char* GetName() override;
+	void Submit(std::vector<ChunkIORequest>& batch) override;
+};
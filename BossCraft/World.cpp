@@ -1,17 +1,32 @@
 #include "World.h"
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+#include "BlockAccessor.h"
 #include "Chunk.h"
 #include "Camera.h"
 #include "EventBase.h"
 #include "ChunkLoadedEvent.h"
 #include "ChunkMesh.h"
+#include "ChunkPool.h"
+#include "ChunkGenerator.h"
+#include "ChunkIO.h"
 #include "ChunkResources.h"
 #include "NeighborChunks.h"
+#include "PendingBlockWrites.h"
 #include "GlobalEventManager.h"
+#include "HeightmapCache.h"
 #include "JobSystem.h"
+#include "MemoryBudget.h"
+#include "Metrics.h"
 #include "Player.h"
-#include "TextureAtlas.h"
+#include "Profiler.h"
 
-World::World(Shader* shader, TextureAtlas* atlas, Player* player) : _shader(shader), _textureAtlas(atlas), _player(player)
+#include <glm/ext/matrix_clip_space.hpp>
+
+World::World(IRenderBackend* renderBackend, Player* player) : _player(player), _renderBackend(renderBackend)
 {
 	player->_world = this;
 	Init();
@@ -20,24 +35,31 @@ World::World(Shader* shader, TextureAtlas* atlas, Player* player) : _shader(shad
 void World::Init()
 {
 	_centerChunk = glm::ivec2(0, 0);
+	_stats = WorldStats();
+	_loadsInFlight = 0;
+	_meshesInFlight = 0;
+	_meshUpdatesInFlight = 0;
+	_bootstrapPending = true;
 	_renderDistance = 12;
 	_extraLoadDistance = 2;
-	_chunkOrigin = glm::ivec2(-_renderDistance, -_renderDistance);
-
-	unsigned int totalChunks = ((2 * _renderDistance) + 1) * ((2 * _renderDistance) + 1);
-	_chunks = std::unordered_map<glm::ivec2, std::shared_ptr<Chunk>>();
+	_lastPlayerPos = _player->_worldPos;
+	_playerVelocity = glm::vec2(0, 0);
+	_prefetchOffset = glm::ivec2(0, 0);
+	_memoryPressure = false;
+	// Edits only remesh the sections they touch; memory-constrained embedders can opt into None
+	_meshRetention = MeshRetention::Compact;
 
-	_noiseGenerator = new FastNoiseLite;
-	_chunksToLoad = std::queue<glm::ivec2>();
-	_chunksToGenMesh = std::queue<glm::ivec2>();
+	_chunks.Resize(2 * GetWindowRadius() + 1);
 
+	_noiseGenerator = new TerrainNoise;
+	_heightmapCache = new HeightmapCache(_noiseGenerator, _maxHeightmapTiles);
+	_pendingWrites = new PendingBlockWrites;
+	_chunkGenerator = new ChunkGenerator(_noiseGenerator, _heightmapCache, _pendingWrites);
+	_chunkPool = new ChunkPool;
+	_chunksToLoad = ChunkQueue();
+	_chunksToGenMesh = ChunkQueue();
 
-	_shader->Use();
-	glm::mat4 projection = glm::perspective(glm::radians(_player->_camera->_fov), 800.f / 600.f, 0.1f, 300.0f);
-	_shader->UniSetMat4f("projection", projection);
-
-	
-	LoadNewChunks();
+	UpdateProjection();
 }
 
 void World::SetCenter(glm::vec3 blockPos)
@@ -48,172 +70,651 @@ void World::SetCenter(glm::vec3 blockPos)
 	{
 		return;
 	}
+	PROFILE_FUNCTION();
 	
-	glm::ivec2 offset = newCenterChunk - _centerChunk;
-	glm::ivec2 oldOrigin = _chunkOrigin;
-	_chunkOrigin += offset;
+	glm::ivec2 oldCenter = _centerChunk;
 	_centerChunk = newCenterChunk;
+	_chunksToLoad.SetCenter(_centerChunk + _prefetchOffset);
+	_chunksToGenMesh.SetCenter(_centerChunk + _prefetchOffset);
 
-	auto it = _chunks.begin();
-	
-	while (it != _chunks.end())
+	// The player jumped past what's loaded; streaming it in nearest first would leave them in the void for a while
+	for (int x = -1; x <= 1; x++)
 	{
-		if (!ChunkInLoadDistance(it->first))
+		for (int z = -1; z <= 1; z++)
 		{
-			//it->second->GLUnload();
-			if (_chunks[it->first] != NULL)
+			if (_chunks.Get(_centerChunk + glm::ivec2(x, z)) == NULL)
 			{
-				std::shared_ptr<Chunk> chunk = _chunks[it->first];
-				JobSystem::Execute([chunk]
-					{
-						ChunkResources::SaveChunk(chunk);
-					});
-				_chunks[it->first] = NULL;
+				_bootstrapPending = true;
 			}
-			it = _chunks.erase(it);
-			//_chunks[chunkPos] = NULL;
 		}
-		else
+	}
+
+	int radius = GetWindowRadius();
+
+	// Only the part of the old load area that isn't in the new one. Chunks that drop out when the heading changes
+	// between two borders wait for the next border, so turning on the spot doesn't unload and reload them.
+	for (int x = oldCenter[0] - radius; x <= oldCenter[0] + radius; x++)
+	{
+		for (int z = oldCenter[1] - radius; z <= oldCenter[1] + radius; z++)
 		{
-			it++;
+			glm::ivec2 pos(x, z);
+			if (!ChunkInLoadDistance(pos))
+			{
+				UnloadChunk(pos);
+			}
 		}
 	}
+
+	for (auto& writes : _pendingWrites->TakeOutside(_centerChunk, radius))
+	{
+		SavePendingWrites(writes.first, std::move(writes.second));
+	}
 	LoadNewChunks();
 }
 
-void World::UpdateBlockAtPos(glm::ivec3 blockPos, uint8_t newBlock)
+void World::Teleport(glm::vec3 blockPos)
+{
+	SetCenter(blockPos);
+	_bootstrapPending = true;
+}
+
+void World::SetViewDistance(uint8_t renderDistance, uint8_t extraLoadDistance)
 {
-	glm::ivec2 chunkPos = BlockPosToAbsChunkPos(blockPos);
-	if (_chunks.find(chunkPos) != _chunks.end())
+	renderDistance = std::max<uint8_t>(renderDistance, 1);
+	// Meshing a chunk needs its neighbours, so the load circle has to reach at least one past the render circle
+	extraLoadDistance = std::max<uint8_t>(extraLoadDistance, 1);
+	if (renderDistance == _renderDistance && extraLoadDistance == _extraLoadDistance)
+	{
+		return;
+	}
+	PROFILE_FUNCTION();
+
+	int oldRadius = GetWindowRadius();
+	_renderDistance = renderDistance;
+	_extraLoadDistance = extraLoadDistance;
+
+	// Whatever is left has to fit the new grid
+	for (int x = _centerChunk[0] - oldRadius; x <= _centerChunk[0] + oldRadius; x++)
 	{
-		glm::ivec3 relBlockPos = AbsBlockPosToChunkBlockPos(blockPos);
-		std::shared_ptr<Chunk> oldChunk = _chunks[chunkPos];
-		// queue for update data
-		JobSystem::Execute([this, oldChunk, relBlockPos, newBlock]
+		for (int z = _centerChunk[1] - oldRadius; z <= _centerChunk[1] + oldRadius; z++)
+		{
+			glm::ivec2 pos(x, z);
+			if (!ChunkInLoadDistance(pos))
 			{
-				std::shared_ptr<Chunk> chunkToUpdate = std::make_shared<Chunk>(*oldChunk);
-				chunkToUpdate->SetData(relBlockPos, newBlock);
-				this->_dataUpdateOutput.Enqueue(new std::pair<glm::ivec3, std::shared_ptr<Chunk>>(relBlockPos, chunkToUpdate));
-			});
+				UnloadChunk(pos);
+			}
+		}
+	}
+	_chunks.Resize(2 * GetWindowRadius() + 1);
+
+	UpdateProjection();
+	// Loaded chunks the render circle has grown over are still waiting in _chunksToGenMesh
+	LoadNewChunks();
+}
+
+uint8_t World::GetRenderDistance()
+{
+	return _renderDistance;
+}
+
+uint8_t World::GetExtraLoadDistance()
+{
+	return _extraLoadDistance;
+}
+
+void World::SetMeshRetention(MeshRetention retention)
+{
+	_meshRetention = retention;
+}
+
+MeshRetention World::GetMeshRetention()
+{
+	return _meshRetention;
+}
+
+void World::ReuploadMeshes()
+{
+	PROFILE_FUNCTION();
+	int radius = GetWindowRadius();
+	for (int x = _centerChunk[0] - radius; x <= _centerChunk[0] + radius; x++)
+	{
+		for (int z = _centerChunk[1] - radius; z <= _centerChunk[1] + radius; z++)
+		{
+			glm::ivec2 pos(x, z);
+			std::shared_ptr<Chunk> chunk = _chunks.Get(pos);
+			if (chunk == NULL || chunk->_state != ChunkState::Uploaded)
+			{
+				continue;
+			}
+			if (chunk->_mesh != NULL)
+			{
+				chunk->BufferMesh();
+			}
+			else
+			{
+				chunk->ReleaseMesh();
+				_chunksToGenMesh.Push(pos);
+			}
+		}
+	}
+}
+
+void World::UnloadChunk(glm::ivec2 pos)
+{
+	std::shared_ptr<Chunk> chunk = _chunks.Erase(pos);
+	if (chunk == NULL)
+	{
+		return;
+	}
+	chunk->_state = ChunkState::Unloading;
+
+	// An edit that hasn't been swapped in yet holds the newest blocks
+	auto edit = _chunkEdits.find(pos);
+	if (edit != _chunkEdits.end())
+	{
+		edit->second.chunk->_state = ChunkState::Unloading;
+		ChunkIO::QueueSave(edit->second.chunk);
+		_chunkEdits.erase(edit);
+	}
+	else
+	{
+		ChunkIO::QueueSave(chunk);
+	}
+	_stats.chunksUnloaded++;
+}
+
+void World::UpdateBlockAtPos(glm::ivec3 blockPos, uint8_t newBlock)
+{
+	ApplyEdits({ BlockEdit{ blockPos, newBlock } });
+}
+
+/**
+ * Applies the edits in order. Every chunk touched is copied at most once per frame and remeshed once, only in the
+ * sections the edits reach, when CreateUpdateMeshTasks runs at the end of the frame.
+ */
+void World::ApplyEdits(const std::vector<BlockEdit>& edits)
+{
+	PROFILE_FUNCTION();
+	static Metrics::Counter& applied = Metrics::GetCounter("world.blockEdits.applied");
+	static Metrics::Counter& skipped = Metrics::GetCounter("world.blockEdits.skipped");
+
+	// Edits tend to come in runs within one chunk; only look the chunk up again when the run ends
+	glm::ivec2 chunkPos(0, 0);
+	std::shared_ptr<Chunk> current = NULL;
+	std::shared_ptr<Chunk> edited = NULL;
+	for (const BlockEdit& edit : edits)
+	{
+		if (edit.blockPos.y < 0 || edit.blockPos.y >= static_cast<int>(CHUNK_HEIGHT))
+		{
+			skipped.Add();
+			continue;
+		}
+
+		glm::ivec2 pos = BlockPosToAbsChunkPos(edit.blockPos);
+		if (current == NULL || pos != chunkPos)
+		{
+			chunkPos = pos;
+			edited = NULL;
+			auto pending = _chunkEdits.find(pos);
+			current = pending != _chunkEdits.end() ? pending->second.chunk : _chunks.Get(pos);
+		}
+		if (current == NULL)
+		{
+			skipped.Add();
+			continue;
+		}
+
+		// Filling over blocks that are already right doesn't need a copy or a remesh
+		glm::ivec3 relBlockPos = AbsBlockPosToChunkBlockPos(edit.blockPos);
+		if (current->GetDataAtPosition(relBlockPos) == edit.block)
+		{
+			skipped.Add();
+			continue;
+		}
+
+		if (edited == NULL)
+		{
+			edited = BeginChunkEdit(chunkPos, 0);
+			current = edited;
+		}
+		edited->SetData(relBlockPos, edit.block);
+		MarkBlockEdited(_chunkEdits[chunkPos], relBlockPos);
+		applied.Add();
+	}
+}
+
+void World::MarkBlockEdited(ChunkEdit& edit, glm::ivec3 relBlockPos)
+{
+	edit.sectionMask |= ChunkMesh::SectionsTouchingBlock(relBlockPos.y);
+
+	// Border blocks also hide or expose a face in the neighbour's mesh, in the section at the same height
+	unsigned int section = 1u << (relBlockPos.y / MESH_SECTION_HEIGHT);
+	if (relBlockPos.x == CHUNK_WIDTH - 1)
+	{
+		edit.neighborSectionMasks[0] |= section;
+	}
+	else if (relBlockPos.x == 0)
+	{
+		edit.neighborSectionMasks[1] |= section;
+	}
+	if (relBlockPos.z == CHUNK_WIDTH - 1)
+	{
+		edit.neighborSectionMasks[2] |= section;
+	}
+	else if (relBlockPos.z == 0)
+	{
+		edit.neighborSectionMasks[3] |= section;
+	}
+}
+
+/**
+ * Returns the copy of the chunk at pos that edits go into, or NULL if it isn't loaded. Mesh jobs and other threads may
+ * be reading the resident chunk, so it is never written; the copy replaces it once its mesh is rebuilt. Edits made
+ * before that mesh job starts share the copy, later ones start a new copy from the newest blocks.
+ */
+std::shared_ptr<Chunk> World::BeginChunkEdit(glm::ivec2 pos, unsigned int sectionMask)
+{
+	std::shared_ptr<Chunk> resident = _chunks.Get(pos);
+	if (resident == NULL)
+	{
+		return NULL;
+	}
+
+	auto pending = _chunkEdits.find(pos);
+	if (pending != _chunkEdits.end() && pending->second.chunk->_state != ChunkState::Meshing)
+	{
+		pending->second.sectionMask |= sectionMask;
+		return pending->second.chunk;
+	}
+
+	ChunkEdit edit{};
+	edit.sectionMask = sectionMask;
+	std::shared_ptr<Chunk> source = resident;
+	if (pending != _chunkEdits.end())
+	{
+		// The mesh of the edit in flight will be dropped, so its sections and neighbours are redone on top of the resident mesh
+		source = pending->second.chunk;
+		edit.sectionMask |= pending->second.sectionMask;
+		edit.neighborSectionMasks = pending->second.neighborSectionMasks;
+	}
+
+	edit.chunk = _chunkPool->Acquire(*source);
+	if (resident->_mesh != NULL)
+	{
+		edit.chunk->_mesh = new ChunkMesh(*resident->_mesh);
+	}
+	else
+	{
+		edit.chunk->_mesh = new ChunkMesh;
+		edit.sectionMask = MESH_ALL_SECTIONS;
 	}
+	edit.chunk->GLLoad();
+
+	_chunkEdits[pos] = edit;
+	_chunksToUpdateMesh.emplace(edit.chunk);
+	return edit.chunk;
+}
+
+void World::ReleaseChunkBuffers(const ChunkRenderHandle& handle, size_t uploadedBytes)
+{
+	std::lock_guard<std::mutex> lock(_releasedBuffersMutex);
+	_releasedBuffers.emplace_back(handle, uploadedBytes);
 }
 
 void World::Update(float dt)
 {
+	PROFILE_FUNCTION();
+
+	UpdatePrefetch(dt);
+	if (_bootstrapPending)
+	{
+		_bootstrapPending = false;
+		Bootstrap();
+	}
+
+	std::vector<glm::ivec2> writeTargets = _pendingWrites->Drain();
+
 	// Check Data Gen
 	std::shared_ptr<Chunk> outChunk;
 	while (_dataGenOutput.Dequeue(outChunk))
 	{
-		_chunks[outChunk->_chunkPos] = outChunk;
+		PROFILE_SCOPE("World::ReceiveChunkData");
+		_loadsInFlight--;
+		ChunkGrid::Slot* slot = _chunks.Find(outChunk->_chunkPos);
+		if (slot == NULL || slot->chunk != NULL)
+		{
+			// Scrolled out of the window while loading, or loaded twice after scrolling back in
+			continue;
+		}
+
+		// Nothing else holds the chunk yet, so neighbour features can be written straight into it
+		_pendingWrites->Apply(outChunk->_chunkPos, outChunk.get());
+		outChunk->_state = ChunkState::Ready;
+		slot->chunk = outChunk;
+		_stats.chunksLoaded++;
 		outChunk->GLLoad();
-		_chunksToGenMesh.emplace(outChunk->_chunkPos);
+		_chunksToGenMesh.Push(outChunk->_chunkPos);
 	}
 
 	// Check Mesh Gen
-	std::pair<glm::ivec2, ChunkMesh*>* outMesh;
+	static Metrics::Histogram& meshBytes = Metrics::GetHistogram("world.meshBytes");
+	MeshResult* outMesh;
 	while (_meshGenOutput.Dequeue(outMesh))
 	{
-		glm::ivec2 pos = outMesh->first;
-		std::shared_ptr<Chunk> chunk = nullptr;
-		if (_chunks.find(pos) != _chunks.end() && (chunk = _chunks[pos]) != NULL)
+		PROFILE_SCOPE("World::ReceiveChunkMesh");
+		_meshesInFlight--;
+		if (outMesh->mesh == NULL)
 		{
-			delete chunk->_mesh;
+			// Unloaded before the job got to it
+			delete outMesh;
+			continue;
+		}
 
-			chunk->_mesh = outMesh->second;
+		std::shared_ptr<Chunk> chunk = outMesh->chunk;
+		glm::ivec2 pos = chunk->_chunkPos;
+		meshBytes.Record(outMesh->mesh->dataIndex * sizeof(uint32_t) + outMesh->mesh->indicesIndex * sizeof(uint16_t));
+		_stats.meshesBuilt++;
+
+		std::shared_ptr<Chunk> resident = _chunks.Get(pos);
+		if (resident == chunk)
+		{
+			delete chunk->_mesh;
+			chunk->_mesh = outMesh->mesh;
 			chunk->BufferMesh();
 		}
+		else
+		{
+			delete outMesh->mesh;
+		}
+
+		// An edited copy of this chunk started from the mesh before this one
+		if (resident != NULL && (resident != chunk || _chunkEdits.find(pos) != _chunkEdits.end()))
+		{
+			BeginChunkEdit(pos, MESH_ALL_SECTIONS);
+		}
+		delete outMesh;
 	}
 
-	// Check Data Update
-	std::pair<glm::ivec3, std::shared_ptr<Chunk>>* outChunkAndPos;
-	while (_dataUpdateOutput.Dequeue(outChunkAndPos))
+	// Check Mesh Update
+	std::shared_ptr<Chunk> editedChunk;
+	while (_meshUpdateOutput.Dequeue(editedChunk))
 	{
-		outChunkAndPos->second->GLLoad();
-		_chunksToUpdateMesh.emplace(*outChunkAndPos);
-		delete outChunkAndPos;
-		
+		PROFILE_SCOPE("World::ReceiveMeshUpdate");
+		_meshUpdatesInFlight--;
+		ReceiveChunkEdit(editedChunk);
 	}
-	
-	// Check Mesh Update
-	
-	while (_meshUpdateOutput.Dequeue(outChunkAndPos))
+
+	std::vector<std::pair<ChunkRenderHandle, size_t>> releasedBuffers;
 	{
-		outChunkAndPos->second->BufferMesh();
-		_chunks[outChunkAndPos->second->_chunkPos] = outChunkAndPos->second;
+		std::lock_guard<std::mutex> lock(_releasedBuffersMutex);
+		releasedBuffers.swap(_releasedBuffers);
+	}
+	for (const std::pair<ChunkRenderHandle, size_t>& released : releasedBuffers)
+	{
+		PROFILE_SCOPE("World::DestroyChunkBuffers");
+		_renderBackend->DestroyChunkBuffers(released.first);
+		MemoryBudget::Add(MemoryCategory::GpuBuffers, -static_cast<int64_t>(released.second));
+	}
+
+	ApplyPendingWritesToResidentChunks(writeTargets);
+	EnforceMemoryBudget();
 
-		glm::ivec2 chunkPos = outChunkAndPos->second->_chunkPos;
-		glm::ivec3 outPos = outChunkAndPos->first;
-		if (outPos.x == 0)
+	CreateGenMeshTasks();
+	CreateLoadChunksTasks();
+	CreateUpdateMeshTasks();
+	ChunkIO::Flush();
+	PublishMetrics();
+	Render();
+}
+
+void World::ApplyPendingWritesToResidentChunks(const std::vector<glm::ivec2>& targets)
+{
+	for (glm::ivec2 pos : targets)
+	{
+		const std::vector<PendingBlockWrites::Write>* writes = _pendingWrites->Find(pos);
+		if (writes == NULL)
 		{
-			glm::ivec2 minusXPos = { chunkPos[0] - 1, chunkPos[1] };
-			if (_chunks.find(minusXPos) != _chunks.end())
-			{
-				_chunksToGenMesh.emplace(minusXPos);
-			}
+			// Already applied this frame
+			continue;
 		}
-		else if (outPos.x == CHUNK_WIDTH - 1)
+
+		std::shared_ptr<Chunk> chunk = BeginChunkEdit(pos, 0);
+		if (chunk == NULL)
 		{
-			glm::ivec2 plusXPos = { chunkPos[0] + 1, chunkPos[1] };
-			if (_chunks.find(plusXPos) != _chunks.end())
-			{
-				_chunksToGenMesh.emplace(plusXPos);
-			}
+			// Not here yet; applied when the chunk arrives
+			continue;
 		}
-		if (outPos.z == 0)
+		ChunkEdit& edit = _chunkEdits[pos];
+		for (const PendingBlockWrites::Write& write : *writes)
 		{
-			glm::ivec2 minusZPos = { chunkPos[0], chunkPos[1] - 1 };
-			if (_chunks.find(minusZPos) != _chunks.end())
+			MarkBlockEdited(edit, glm::ivec3(write.localPos));
+		}
+		_pendingWrites->Apply(pos, chunk.get());
+	}
+}
+
+/**
+ * Writes for a chunk that left the window. A chunk that was ever saved gets them in its file; one that was never
+ * generated has nowhere to keep them, so they are dropped rather than held for a chunk that may never load.
+ */
+void World::SavePendingWrites(glm::ivec2 pos, std::vector<PendingBlockWrites::Write>&& writes)
+{
+	static Metrics::Counter& saved = Metrics::GetCounter("world.pendingWrites.saved");
+	static Metrics::Counter& dropped = Metrics::GetCounter("world.pendingWrites.dropped");
+
+	ChunkIO::QueueLoad(_chunkPool->Acquire(pos, this), [writes = std::move(writes)](std::shared_ptr<Chunk> chunk, bool loadedFromFile)
+		{
+			if (!loadedFromFile)
 			{
-				_chunksToGenMesh.emplace(minusZPos);
+				dropped.Add(writes.size());
+				return;
 			}
+			PendingBlockWrites::ApplyTo(chunk.get(), writes);
+			ChunkIO::QueueSave(chunk);
+			saved.Add(writes.size());
+		});
+}
+
+void World::ReceiveChunkEdit(std::shared_ptr<Chunk> chunk)
+{
+	static Metrics::Histogram& meshBytes = Metrics::GetHistogram("world.meshBytes");
+
+	glm::ivec2 pos = chunk->_chunkPos;
+	auto edit = _chunkEdits.find(pos);
+	if (edit == _chunkEdits.end() || edit->second.chunk != chunk)
+	{
+		// Superseded by a newer copy or unloaded meanwhile
+		return;
+	}
+	std::array<unsigned int, 4> neighborMasks = edit->second.neighborSectionMasks;
+	_chunkEdits.erase(edit);
+
+	if (chunk->_mesh != NULL)
+	{
+		_stats.meshesBuilt++;
+		meshBytes.Record(chunk->_mesh->dataIndex * sizeof(uint32_t) + chunk->_mesh->indicesIndex * sizeof(uint16_t));
+		chunk->BufferMesh();
+	}
+	_chunks.Set(pos, chunk);
+
+	std::array<glm::ivec2, 4> poses = {
+		glm::ivec2(pos[0] + 1, pos[1]),
+		glm::ivec2(pos[0] - 1, pos[1]),
+		glm::ivec2(pos[0], pos[1] + 1),
+		glm::ivec2(pos[0], pos[1] - 1)
+	};
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		if (neighborMasks[i] != 0)
+		{
+			// Goes through the same copy as an edit, so it coalesces with any edit of the neighbour in flight
+			BeginChunkEdit(poses[i], neighborMasks[i]);
 		}
-		else if (outPos.z == CHUNK_WIDTH - 1)
+	}
+}
+
+/**
+ * Keeps MemoryBudget under its limit by dropping, farthest chunks first, what is cheapest to get back: CPU copies of
+ * uploaded meshes (the GPU keeps drawing them, and an edit remeshes every section instead of a few), then the meshes
+ * of chunks that aren't drawn, then the blocks of chunks outside what meshing the render circle needs, which are
+ * saved on the way out. Until the total is back below nine tenths of the limit, nothing outside that is loaded or
+ * meshed, so what was evicted doesn't come straight back.
+ */
+void World::EnforceMemoryBudget()
+{
+	static Metrics::Counter& cpuMeshesEvicted = Metrics::GetCounter("memory.evicted.cpuMeshes");
+	static Metrics::Counter& meshesEvicted = Metrics::GetCounter("memory.evicted.meshes");
+	static Metrics::Counter& chunksEvicted = Metrics::GetCounter("memory.evicted.chunks");
+
+	MemoryBudget::Set(MemoryCategory::BlockData,
+		_chunkPool->GetLiveCount() * sizeof(Chunk) + _chunkPool->GetLiveSectionCount() * sizeof(ChunkSection));
+	int64_t excess = static_cast<int64_t>(MemoryBudget::GetExcess());
+	if (excess == 0)
+	{
+		uint64_t limit = MemoryBudget::GetLimit();
+		if (_memoryPressure && (limit == 0 || MemoryBudget::GetTotalBytes() < limit / 10 * 9))
 		{
-			glm::ivec2 plusZPos = { chunkPos[0], chunkPos[1] + 1 };
-			if (_chunks.find(plusZPos) != _chunks.end())
+			// Queue again whatever was evicted
+			_memoryPressure = false;
+			LoadNewChunks();
+		}
+		return;
+	}
+	PROFILE_FUNCTION();
+	_memoryPressure = true;
+
+	std::vector<std::pair<int, std::shared_ptr<Chunk>>> candidates;
+	int radius = GetWindowRadius();
+	for (int x = _centerChunk[0] - radius; x <= _centerChunk[0] + radius; x++)
+	{
+		for (int z = _centerChunk[1] - radius; z <= _centerChunk[1] + radius; z++)
+		{
+			glm::ivec2 pos(x, z);
+			std::shared_ptr<Chunk> chunk = _chunks.Get(pos);
+			// A chunk being edited is about to be replaced by its copy
+			if (chunk != NULL && _chunkEdits.find(pos) == _chunkEdits.end())
 			{
-				_chunksToGenMesh.emplace(plusZPos);
+				glm::ivec2 offset = pos - _centerChunk;
+				candidates.emplace_back(offset.x * offset.x + offset.y * offset.y, chunk);
 			}
 		}
+	}
+	std::sort(candidates.begin(), candidates.end(),
+		[](const std::pair<int, std::shared_ptr<Chunk>>& a, const std::pair<int, std::shared_ptr<Chunk>>& b) { return a.first > b.first; });
 
-		delete outChunkAndPos;
+	for (auto& candidate : candidates)
+	{
+		Chunk* chunk = candidate.second.get();
+		if (excess <= 0)
+		{
+			return;
+		}
+		if (chunk->_state == ChunkState::Uploaded && chunk->_mesh != NULL)
+		{
+			excess -= chunk->_mesh->accountedBytes;
+			delete chunk->_mesh;
+			chunk->_mesh = NULL;
+			cpuMeshesEvicted.Add();
+		}
 	}
-	
-	std::array<unsigned int, 3>* outBuffers;
-	while (_chunkUnload.Dequeue(outBuffers))
+
+	for (auto& candidate : candidates)
+	{
+		Chunk* chunk = candidate.second.get();
+		if (excess <= 0)
+		{
+			return;
+		}
+		if (chunk->_state == ChunkState::Uploaded && !ChunkInRenderDistance(chunk->_chunkPos))
+		{
+			excess -= chunk->_uploadedBytes;
+			chunk->ReleaseMesh();
+			// Meshed again if the player heads its way
+			_chunksToGenMesh.Push(chunk->_chunkPos);
+			meshesEvicted.Add();
+		}
+	}
+
+	for (auto& candidate : candidates)
 	{
-		// Delete VAO
-		glDeleteVertexArrays(1, &(*outBuffers)[0]);
-		glDeleteBuffers(1, &(*outBuffers)[1]);
-		glDeleteBuffers(1, &(*outBuffers)[2]);
+		Chunk* chunk = candidate.second.get();
+		if (excess <= 0 || ChunkInRadius(chunk->_chunkPos, _renderDistance + 1))
+		{
+			// Sorted farthest first, so everything after this is needed too
+			return;
+		}
+		excess -= sizeof(Chunk) + chunk->_uploadedBytes;
+		for (const std::shared_ptr<ChunkSection>& section : chunk->_sections)
+		{
+			if (section != Chunk::GetEmptySection())
+			{
+				excess -= sizeof(ChunkSection);
+			}
+		}
+		UnloadChunk(chunk->_chunkPos);
+		chunksEvicted.Add();
 	}
+}
 
-	CreateGenMeshTasks();
-	CreateLoadChunksTasks();
-	CreateUpdateMeshTasks();
-	Render();
+void World::PublishMetrics()
+{
+	static Metrics::Gauge& chunks = Metrics::GetGauge("world.chunks");
+	static Metrics::Gauge& chunksToLoad = Metrics::GetGauge("world.queue.chunksToLoad");
+	static Metrics::Gauge& chunksToGenMesh = Metrics::GetGauge("world.queue.chunksToGenMesh");
+	static Metrics::Gauge& chunksToUpdateMesh = Metrics::GetGauge("world.queue.chunksToUpdateMesh");
+	static Metrics::Gauge& dataGenOutput = Metrics::GetGauge("world.queue.dataGenOutput");
+	static Metrics::Gauge& meshGenOutput = Metrics::GetGauge("world.queue.meshGenOutput");
+	static Metrics::Gauge& chunkUnload = Metrics::GetGauge("world.queue.chunkUnload");
+	static Metrics::Gauge& meshUpdateOutput = Metrics::GetGauge("world.queue.meshUpdateOutput");
+	static Metrics::Gauge& loadsInFlight = Metrics::GetGauge("world.loadsInFlight");
+	static Metrics::Gauge& meshesInFlight = Metrics::GetGauge("world.meshesInFlight");
+	static Metrics::Gauge& meshUpdatesInFlight = Metrics::GetGauge("world.meshUpdatesInFlight");
+	static Metrics::Gauge& jobQueueDepth = Metrics::GetGauge("jobs.queueDepth");
+	static Metrics::Gauge& pendingWriteChunks = Metrics::GetGauge("world.pendingWrites.chunks");
+	static Metrics::Gauge& poolSlots = Metrics::GetGauge("world.chunkPool.slots");
+	static Metrics::Gauge& poolLive = Metrics::GetGauge("world.chunkPool.live");
+	static Metrics::Gauge& poolSectionSlots = Metrics::GetGauge("world.chunkPool.sectionSlots");
+	static Metrics::Gauge& poolSectionsLive = Metrics::GetGauge("world.chunkPool.sectionsLive");
+
+	chunks.Set(_chunks.GetUsedCount());
+	chunksToLoad.Set(_chunksToLoad.Size());
+	chunksToGenMesh.Set(_chunksToGenMesh.Size());
+	chunksToUpdateMesh.Set(_chunksToUpdateMesh.size());
+	dataGenOutput.Set(_dataGenOutput.Size());
+	meshGenOutput.Set(_meshGenOutput.Size());
+	{
+		std::lock_guard<std::mutex> lock(_releasedBuffersMutex);
+		chunkUnload.Set(_releasedBuffers.size());
+	}
+	meshUpdateOutput.Set(_meshUpdateOutput.Size());
+	loadsInFlight.Set(_loadsInFlight);
+	meshesInFlight.Set(_meshesInFlight);
+	meshUpdatesInFlight.Set(_meshUpdatesInFlight);
+	jobQueueDepth.Set(JobSystem::GetQueueDepth());
+	pendingWriteChunks.Set(_pendingWrites->GetPendingChunkCount());
+	poolSlots.Set(_chunkPool->GetSlotCount());
+	poolLive.Set(_chunkPool->GetLiveCount());
+	poolSectionSlots.Set(_chunkPool->GetSectionSlotCount());
+	poolSectionsLive.Set(_chunkPool->GetLiveSectionCount());
+	MemoryBudget::PublishMetrics();
 }
 
 void World::Render()
 {
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, _textureAtlas->_textureID);
+	PROFILE_FUNCTION();
+
+	_renderBackend->BeginFrame(_player->_camera->GetViewMatrix());
 
 	
-	_shader->Use();
-	//_shader->UniSetMat4f("view", _mainCamera->GetViewMatrix());
-	_shader->SetViewMatrix(_player->_camera->GetViewMatrix());
-	
-	
-	for (int x = _chunkOrigin[0]; x < _chunkOrigin[0] + (_renderDistance * 2) + 1; x++)
+	for (int x = _centerChunk[0] - _renderDistance; x <= _centerChunk[0] + _renderDistance; x++)
 	{
-		for (int z = _chunkOrigin[1]; z < _chunkOrigin[1] + (_renderDistance * 2) + 1; z++)
+		for (int z = _centerChunk[1] - _renderDistance; z <= _centerChunk[1] + _renderDistance; z++)
 		{
 			glm::ivec2 pos = glm::ivec2(x, z);
-			std::shared_ptr<Chunk> chunk = NULL;
-			if (_chunks.find(pos) != _chunks.end() && (chunk = _chunks[pos]) != NULL)
+			std::shared_ptr<Chunk> chunk = _chunks.Get(pos);
+			if (chunk != NULL && ChunkInRenderDistance(pos))
 			{
-				chunk->RenderMesh(_shader);
+				chunk->RenderMesh(_renderBackend);
 			}
 		}
 	}
@@ -221,18 +722,12 @@ void World::Render()
 
 uint8_t World::GetBlockAtAbsPos(glm::ivec3 blockPos)
 {
-	if (blockPos.y < 0 || blockPos.y >= CHUNK_HEIGHT) return 0;
-	
-	// Assumes that block is inside of render distance!
-	glm::ivec2 chunkPos = BlockPosToAbsChunkPos(blockPos);
-
-	// Get block's position inside of the chunk
-	std::shared_ptr<Chunk> chunk = _chunks[chunkPos];
-	glm::vec3 pos = glm::vec3(blockPos.x - (chunkPos[0] * CHUNK_WIDTH), blockPos.y, blockPos.z - (chunkPos[1] * CHUNK_WIDTH));
+	return BlockAccessor(this).GetBlock(blockPos);
+}
 
-	//if (pos.x <= 0 || pos.x >= CHUNK_WIDTH || pos.z <= 0 || pos.z >= CHUNK_WIDTH) return 0;
-	
-	return chunk->GetDataAtPosition(pos);
+void World::GetBlocks(const glm::ivec3* positions, size_t count, uint8_t* out)
+{
+	BlockAccessor(this).GetBlocks(positions, count, out);
 }
 
 Camera* World::GetCamera()
@@ -240,23 +735,170 @@ Camera* World::GetCamera()
 	return _player->_camera;
 }
 
-Shader* World::GetShader()
+IRenderBackend* World::GetRenderBackend()
+{
+	return _renderBackend;
+}
+
+/**
+ * Loads and meshes everything within _bootstrapDistance of the center across all the workers and waits for it, so the
+ * first frame after spawning or teleporting already has ground under the player. The rest of the window is queued and
+ * streams in nearest first as usual.
+ */
+void World::Bootstrap()
+{
+	PROFILE_FUNCTION();
+	static Metrics::Histogram& bootstrapUs = Metrics::GetHistogram("world.bootstrapUs");
+	static Metrics::Histogram& meshBytes = Metrics::GetHistogram("world.meshBytes");
+	uint64_t startNs = Profiler::NowNs();
+
+	// Meshing a chunk needs its four neighbours, so load one ring further than we mesh
+	const int meshRadius = std::min<int>(_bootstrapDistance, _renderDistance);
+	const int loadRadius = meshRadius + 1;
+
+	std::vector<std::shared_ptr<Chunk>> loaded;
+	for (int x = _centerChunk[0] - loadRadius; x <= _centerChunk[0] + loadRadius; x++)
+	{
+		for (int z = _centerChunk[1] - loadRadius; z <= _centerChunk[1] + loadRadius; z++)
+		{
+			glm::ivec2 pos(x, z);
+			// A load already in flight for pos is dropped when it lands in a filled slot
+			if (ChunkInLoadDistance(pos) && _chunks.Get(pos) == NULL && _chunks.Reserve(pos))
+			{
+				loaded.emplace_back(_chunkPool->Acquire(pos, this));
+			}
+		}
+	}
+
+	// Only wait on our own jobs; streaming jobs may be waiting on this thread to drain their output
+	std::atomic<uint32_t> loadsLeft(static_cast<uint32_t>(loaded.size()));
+	JobSystem::Dispatch(static_cast<uint32_t>(loaded.size()), 1, [&loaded, &loadsLeft](JobDispatchArgs args)
+		{
+			loaded[args.jobIndex]->LoadData();
+			loadsLeft--;
+		});
+	JobSystem::Wait(loadsLeft);
+
+	std::vector<glm::ivec2> writeTargets = _pendingWrites->Drain();
+	for (std::shared_ptr<Chunk>& chunk : loaded)
+	{
+		_pendingWrites->Apply(chunk->_chunkPos, chunk.get());
+		chunk->_state = ChunkState::Ready;
+		_chunks.Find(chunk->_chunkPos)->chunk = chunk;
+		_stats.chunksLoaded++;
+		chunk->GLLoad();
+	}
+	ApplyPendingWritesToResidentChunks(writeTargets);
+
+	struct BootstrapMesh
+	{
+		std::shared_ptr<Chunk> chunk;
+		std::array<std::shared_ptr<Chunk>, 4> neighbors;
+		ChunkMesh* mesh;
+	};
+	std::vector<BootstrapMesh> meshes;
+	for (int x = _centerChunk[0] - meshRadius; x <= _centerChunk[0] + meshRadius; x++)
+	{
+		for (int z = _centerChunk[1] - meshRadius; z <= _centerChunk[1] + meshRadius; z++)
+		{
+			glm::ivec2 pos(x, z);
+			std::shared_ptr<Chunk> chunk = _chunks.Get(pos);
+			BootstrapMesh job{ chunk, {}, NULL };
+			if (chunk != NULL && chunk->_state == ChunkState::Ready && ChunkInRenderDistance(pos) && GetNeighbors(pos, job.neighbors))
+			{
+				chunk->_state = ChunkState::Meshing;
+				meshes.emplace_back(std::move(job));
+			}
+		}
+	}
+
+	std::atomic<uint32_t> meshesLeft(static_cast<uint32_t>(meshes.size()));
+	JobSystem::Dispatch(static_cast<uint32_t>(meshes.size()), 1, [&meshes, &meshesLeft](JobDispatchArgs args)
+		{
+			BootstrapMesh& job = meshes[args.jobIndex];
+			job.mesh = job.chunk->GenerateMesh(job.neighbors);
+			meshesLeft--;
+		});
+	JobSystem::Wait(meshesLeft);
+
+	for (BootstrapMesh& job : meshes)
+	{
+		meshBytes.Record(job.mesh->dataIndex * sizeof(uint32_t) + job.mesh->indicesIndex * sizeof(uint16_t));
+		_stats.meshesBuilt++;
+		delete job.chunk->_mesh;
+		job.chunk->_mesh = job.mesh;
+		job.chunk->BufferMesh();
+	}
+
+	// The outer ring was only loaded for its neighbours' sake and gets meshed by streaming
+	for (std::shared_ptr<Chunk>& chunk : loaded)
+	{
+		if (chunk->_state == ChunkState::Ready)
+		{
+			_chunksToGenMesh.Push(chunk->_chunkPos);
+		}
+	}
+	LoadNewChunks();
+
+	bootstrapUs.Record((Profiler::NowNs() - startNs) / 1000);
+}
+
+/**
+ * Estimates where the player is heading from how _worldPos moved and points the load and mesh queues that many chunks
+ * ahead, so chunks in the direction of travel are ready before the player crosses into them.
+ */
+void World::UpdatePrefetch(float dt)
+{
+	glm::vec3 playerPos = _player->_worldPos;
+	glm::vec3 moved = playerPos - _lastPlayerPos;
+	_lastPlayerPos = playerPos;
+	if (_bootstrapPending || dt <= 0)
+	{
+		// A teleport isn't travel
+		_playerVelocity = glm::vec2(0, 0);
+		moved = glm::vec3(0);
+		dt = 1;
+	}
+
+	// Smoothed over a few frames so a single jittery frame doesn't swing the whole load order
+	glm::vec2 velocity = glm::vec2(moved.x, moved.z) / dt;
+	_playerVelocity += (velocity - _playerVelocity) * std::min(1.f, dt * 8.f);
+
+	glm::vec2 lead = _playerVelocity * (_prefetchSeconds / CHUNK_WIDTH);
+	float leadLength = glm::length(lead);
+	if (leadLength > _maxPrefetchChunks)
+	{
+		lead *= _maxPrefetchChunks / leadLength;
+	}
+	glm::ivec2 offset(static_cast<int>(std::round(lead.x)), static_cast<int>(std::round(lead.y)));
+	if (offset == _prefetchOffset)
+	{
+		return;
+	}
+
+	_prefetchOffset = offset;
+	_chunksToLoad.SetCenter(_centerChunk + _prefetchOffset);
+	_chunksToGenMesh.SetCenter(_centerChunk + _prefetchOffset);
+	LoadNewChunks();
+}
+
+// Furthest a loaded chunk can be from _centerChunk along either axis
+int World::GetWindowRadius()
 {
-	return _shader;
+	return _renderDistance + _extraLoadDistance + _maxPrefetchChunks;
 }
 
 void World::LoadNewChunks()
 {
-	for (int x = _chunkOrigin[0] - _extraLoadDistance; x < _chunkOrigin[0] + (_renderDistance * 2) + 1 + _extraLoadDistance; x++)
+	int radius = GetWindowRadius();
+	for (int x = _centerChunk[0] - radius; x <= _centerChunk[0] + radius; x++)
 	{
-		for (int z = _chunkOrigin[1] - _extraLoadDistance; z < _chunkOrigin[1] + (_renderDistance * 2) + 1 + _extraLoadDistance; z++)
+		for (int z = _centerChunk[1] - radius; z <= _centerChunk[1] + radius; z++)
 		{
 			glm::ivec2 pos = glm::ivec2(x, z);
-			std::shared_ptr<Chunk> chunk;
-			if (_chunks.find(pos) == _chunks.end())
+			if (ChunkInLoadDistance(pos) && !_chunks.Contains(pos) && _chunks.Reserve(pos))
 			{
-				_chunks[pos] = NULL;
-				_chunksToLoad.push(pos);
+				_chunksToLoad.Push(pos);
 			}
 		}
 	}
@@ -264,55 +906,106 @@ void World::LoadNewChunks()
 
 void World::CreateLoadChunksTasks()
 {
+	PROFILE_FUNCTION();
+	static Metrics::Counter& loadedFromDisk = Metrics::GetCounter("world.chunksLoadedFromDisk");
+	static Metrics::Counter& generated = Metrics::GetCounter("world.chunksGenerated");
+
+	// Over the memory budget only what meshing the render circle needs is loaded; the rest waits in the queue
+	const int neededRadius = _renderDistance + 1;
+	float neededReach = std::sqrt(static_cast<float>(neededRadius * neededRadius + neededRadius)) +
+		glm::length(glm::vec2(_prefetchOffset));
+	const int maxDistanceSquared = _memoryPressure ? static_cast<int>(neededReach * neededReach) : std::numeric_limits<int>::max();
+	std::vector<glm::ivec2> deferred;
+
 	size_t count = 0;
-	while (count < _maxJobs && !_chunksToLoad.empty())
+	while (count < _maxLoadRequests && _loadsInFlight < _maxResultsInFlight && !_chunksToLoad.Empty())
 	{
-		glm::ivec2 pos = _chunksToLoad.front();
-		_chunksToLoad.pop();
+		glm::ivec2 pos = _chunksToLoad.Top();
+		if (_chunksToLoad.DistanceSquared(pos) > maxDistanceSquared)
+		{
+			break;
+		}
+		_chunksToLoad.Pop();
+		ChunkGrid::Slot* slot = _chunks.Find(pos);
+		if (slot == NULL || slot->chunk != NULL)
+		{
+			// Scrolled out of the window before its turn came, or bootstrapped while it waited
+			continue;
+		}
+		if (_memoryPressure && !ChunkInRadius(pos, neededRadius))
+		{
+			deferred.emplace_back(pos);
+			continue;
+		}
+		_loadsInFlight++;
 
-		JobSystem::Execute([this, pos]
+		// Disk reads go out as one batch at the end of the frame; only chunks without a save file take a worker
+		ChunkIO::QueueLoad(_chunkPool->Acquire(pos, this), [this](std::shared_ptr<Chunk> chunk, bool loadedFromFile)
 			{
-				std::shared_ptr<Chunk> chunkToCreate = std::make_shared<Chunk>(pos, this);
-				chunkToCreate->LoadData();
-				this->_dataGenOutput.Enqueue(chunkToCreate);
+				if (loadedFromFile)
+				{
+					loadedFromDisk.Add();
+					chunk->_isDirty = false;
+					while (!this->_dataGenOutput.Enqueue(chunk)) { std::this_thread::yield(); }
+					return;
+				}
+
+				generated.Add();
+				JobSystem::Execute([this, chunk]
+					{
+						chunk->GenerateData();
+						while (!this->_dataGenOutput.Enqueue(chunk)) { std::this_thread::yield(); }
+					});
 			});
 		
 		count++;
 	}
+
+	for (glm::ivec2 pos : deferred)
+	{
+		_chunksToLoad.Push(pos);
+	}
 }
 
 void World::CreateGenMeshTasks()
 {
+	PROFILE_FUNCTION();
+	// Nothing further than the edge of the render circle can be in it; those wait in the queue untouched. The queue is
+	// ordered from the prefetch point, so the far edge is the prefetch offset further away.
+	float reach = std::sqrt(static_cast<float>(_renderDistance * _renderDistance + _renderDistance)) +
+		glm::length(glm::vec2(_prefetchOffset));
+	const int maxDistanceSquared = static_cast<int>(reach * reach);
 	std::vector<glm::ivec2> outsideRange;
-	while (!_chunksToGenMesh.empty())
+	while (!_chunksToGenMesh.Empty() && _meshesInFlight < _maxResultsInFlight)
 	{
-		glm::ivec2 pos = _chunksToGenMesh.front();
-		_chunksToGenMesh.pop();
+		glm::ivec2 pos = _chunksToGenMesh.Top();
+		if (_chunksToGenMesh.DistanceSquared(pos) > maxDistanceSquared)
+		{
+			break;
+		}
+		_chunksToGenMesh.Pop();
 
-		if (!ChunkInRenderDistance(pos))
+		std::shared_ptr<Chunk> chunk = _chunks.Get(pos);
+		if (chunk == NULL || chunk->_state != ChunkState::Ready)
 		{
-			outsideRange.emplace_back(pos);
+			// Unloaded, or reloading after scrolling back in, which queues it again; or already meshed by Bootstrap
 			continue;
 		}
-		
-		if (_chunks.find(pos) != _chunks.end())
+
+		if (!ChunkInMeshDistance(pos) || !CreateSingleGenMeshTask(pos))
 		{
-			if (!CreateSingleGenMeshTask(pos))
-			{
-				outsideRange.emplace_back(pos);
-			}
+			outsideRange.emplace_back(pos);
 		}
 	}
 
 	for (auto pos : outsideRange)
 	{
-		_chunksToGenMesh.emplace(pos);
+		_chunksToGenMesh.Push(pos);
 	}
 }
 
-bool World::CreateSingleGenMeshTask(glm::ivec2 pos)
+bool World::GetNeighbors(glm::ivec2 pos, std::array<std::shared_ptr<Chunk>, 4>& neighbors)
 {
-	std::array<std::shared_ptr<Chunk>, 4> neighbors{};
 	std::array<glm::ivec2, 4> poses = {
 		glm::ivec2(pos[0] + 1, pos[1]),
 		glm::ivec2(pos[0] - 1, pos[1]),
@@ -321,111 +1014,146 @@ bool World::CreateSingleGenMeshTask(glm::ivec2 pos)
 	};
 	for (unsigned int posIdx = 0; posIdx < 4; posIdx++)
 	{
-		glm::ivec2 currPos = poses[posIdx];
-		if (_chunks.find(currPos) != _chunks.end() && _chunks[currPos] != NULL)
-		{
-			neighbors[posIdx] = _chunks[currPos];
-		}
-		else
+		neighbors[posIdx] = _chunks.Get(poses[posIdx]);
+		if (neighbors[posIdx] == NULL)
 		{
 			return false;
 		}
 	}
+	return true;
+}
+
+bool World::CreateSingleGenMeshTask(glm::ivec2 pos)
+{
+	std::array<std::shared_ptr<Chunk>, 4> neighbors{};
+	if (!GetNeighbors(pos, neighbors))
+	{
+		return false;
+	}
 
-	std::shared_ptr<Chunk> chunk = _chunks[pos];
-	JobSystem::Execute([this, chunk, neighbors]
+	std::shared_ptr<Chunk> chunk = _chunks.Get(pos);
+	// A chunk that is already drawn keeps drawing its old mesh until the new one lands
+	if (chunk->_state == ChunkState::Ready)
 	{
-		ChunkMesh* mesh = chunk->GenerateMesh(neighbors);
-		_meshGenOutput.Enqueue(new std::pair<glm::vec<2, int, glm::defaultp>, ChunkMesh*>((chunk->_chunkPos), mesh));
+		chunk->_state = ChunkState::Meshing;
+	}
+	_meshesInFlight++;
+	// The job holds the neighbours so their blocks outlive an unload while it runs
+	JobSystem::Execute([this, chunk = std::move(chunk), neighbors = std::move(neighbors)]
+	{
+		ChunkMesh* mesh = chunk->_state != ChunkState::Unloading ? chunk->GenerateMesh(neighbors) : NULL;
+		_meshGenOutput.Enqueue(new MeshResult{ chunk, mesh });
 	});
 	return true;
 }
 
 void World::CreateUpdateMeshTasks()
 {
-	std::vector<std::pair<glm::ivec3, std::shared_ptr<Chunk>>> outsideRange;
-	while (!_chunksToUpdateMesh.empty())
+	PROFILE_FUNCTION();
+	std::vector<std::shared_ptr<Chunk>> outsideRange;
+	// The rest wait their turn so results never back up in _meshUpdateOutput
+	while (!_chunksToUpdateMesh.empty() && _meshUpdatesInFlight < _maxResultsInFlight)
 	{
-		std::pair<glm::ivec3, std::shared_ptr<Chunk>> chunkAndPos = _chunksToUpdateMesh.front();
+		std::shared_ptr<Chunk> chunk = _chunksToUpdateMesh.front();
 		_chunksToUpdateMesh.pop();
 
-		if (!CreateSingleUpdateMeshTask(chunkAndPos))
+		if (!CreateSingleUpdateMeshTask(chunk))
 		{
-			outsideRange.emplace_back(chunkAndPos);
+			outsideRange.emplace_back(chunk);
 		}
 	}
 
-	for (auto chunkAndPos : outsideRange)
+	for (auto chunk : outsideRange)
 	{
-		_chunksToUpdateMesh.emplace(chunkAndPos);
+		_chunksToUpdateMesh.emplace(chunk);
 	}
 }
 
-bool World::CreateSingleUpdateMeshTask(std::pair<glm::ivec3, std::shared_ptr<Chunk>> chunkAndBlockPos)
+bool World::CreateSingleUpdateMeshTask(std::shared_ptr<Chunk> chunk)
 {
-	std::shared_ptr<Chunk> chunk = chunkAndBlockPos.second;
 	glm::ivec2 pos = chunk->_chunkPos;
+	auto edit = _chunkEdits.find(pos);
+	if (edit == _chunkEdits.end() || edit->second.chunk != chunk)
+	{
+		// Chunk was unloaded before its edit was meshed
+		return true;
+	}
+
+	if (!ChunkInMeshDistance(pos))
+	{
+		// Not drawn, so don't wait on neighbours for a mesh; a full one is built if it comes back into range. The copy
+		// goes in without a mesh even if the chunk had one or was being meshed, so it always has to be queued again.
+		_chunksToGenMesh.Push(pos);
+		delete chunk->_mesh;
+		chunk->_mesh = NULL;
+		ReceiveChunkEdit(chunk);
+		return true;
+	}
+
 	std::array<std::shared_ptr<Chunk>, 4> neighbors{};
-	std::array<glm::ivec2, 4> poses = {
-		glm::ivec2(pos[0] + 1, pos[1]),
-		glm::ivec2(pos[0] - 1, pos[1]),
-		glm::ivec2(pos[0], pos[1] + 1),
-		glm::ivec2(pos[0], pos[1] - 1)
-	};
-	for (unsigned int posIdx = 0; posIdx < 4; posIdx++)
+	if (!GetNeighbors(pos, neighbors))
 	{
-		glm::ivec2 currPos = poses[posIdx];
-		if (_chunks.find(currPos) != _chunks.end() && _chunks[currPos] != NULL)
-		{
-			neighbors[posIdx] = _chunks[currPos];
-		}
-		else
-		{
-			return false;
-		}
+		return false;
 	}
-	glm::ivec3 blockPos = chunkAndBlockPos.first;
-	JobSystem::Execute([this, chunk, neighbors, blockPos]
+
+	// Later edits to this chunk have to start a new copy from here on
+	chunk->_state = ChunkState::Meshing;
+	unsigned int sectionMask = edit->second.sectionMask;
+	_meshUpdatesInFlight++;
+	JobSystem::Execute([this, chunk = std::move(chunk), neighbors = std::move(neighbors), sectionMask]
 		{
-			ChunkMesh* mesh = chunk->GenerateMesh(neighbors);
-			chunk->_mesh = mesh;
-			_meshUpdateOutput.Enqueue(new std::pair<glm::ivec3, std::shared_ptr<Chunk>>(blockPos, chunk));
+			if (chunk->_state != ChunkState::Unloading)
+			{
+				chunk->RebuildMesh(neighbors, chunk->_mesh, sectionMask);
+			}
+			while (!_meshUpdateOutput.Enqueue(chunk)) { std::this_thread::yield(); }
 		});
 	return true;
 }
 
-unsigned World::AbsChunkPosToRelIndex(glm::ivec2 chunkPos)
+glm::ivec3 World::AbsBlockPosToChunkBlockPos(glm::ivec3 absBlockPos)
 {
-	glm::ivec2 relChunkPos = chunkPos - /*-*/_centerChunk;
-	return RelChunkPosToRelIndex(relChunkPos);
+	return glm::ivec3(absBlockPos.x & (CHUNK_WIDTH - 1), absBlockPos.y, absBlockPos.z & (CHUNK_WIDTH - 1));
 }
 
-unsigned World::RelChunkPosToRelIndex(glm::ivec2 chunkPos)
+bool World::BlockInRenderDistance(glm::ivec3 blockPos)
 {
-	unsigned int totalDistance = (_renderDistance * 2) + 1;
-	return (chunkPos[1] + _renderDistance) * totalDistance + (chunkPos[0] + _renderDistance);
+	if (blockPos.y < 0) return false;
+	glm::ivec2 absChunkPos = BlockPosToAbsChunkPos(blockPos);
+	return ChunkInRenderDistance(absChunkPos);
 }
 
-glm::ivec3 World::AbsBlockPosToChunkBlockPos(glm::ivec3 absBlockPos)
+glm::ivec2 World::BlockPosToAbsChunkPos(glm::ivec3 blockPos)
 {
-	return glm::ivec3(absBlockPos.x % CHUNK_WIDTH, absBlockPos.y, absBlockPos.z % CHUNK_WIDTH);
+	return glm::ivec2(blockPos.x >> CHUNK_WIDTH_SHIFT, blockPos.z >> CHUNK_WIDTH_SHIFT);
 }
 
-unsigned World::BlockPosToRelChunkIndex(glm::ivec3 blockPos)
+bool World::IsChunkDrawn(glm::ivec2 chunkPos)
 {
-	return AbsChunkPosToRelIndex(BlockPosToAbsChunkPos(blockPos));
+	ChunkGrid::Slot* slot = _chunks.Find(chunkPos);
+	return slot != NULL && slot->chunk != NULL && slot->chunk->_state == ChunkState::Uploaded;
 }
 
-bool World::BlockInRenderDistance(glm::ivec3 blockPos)
+size_t World::GetResidentChunkCount()
 {
-	if (blockPos.y < 0) return false;
-	glm::ivec2 absChunkPos = BlockPosToAbsChunkPos(blockPos);
-	return ChunkInRenderDistance(absChunkPos);
+	size_t count = 0;
+	int radius = GetWindowRadius();
+	for (int x = _centerChunk[0] - radius; x <= _centerChunk[0] + radius; x++)
+	{
+		for (int z = _centerChunk[1] - radius; z <= _centerChunk[1] + radius; z++)
+		{
+			if (_chunks.Get(glm::ivec2(x, z)) != NULL)
+			{
+				count++;
+			}
+		}
+	}
+	return count;
 }
 
-glm::ivec2 World::BlockPosToAbsChunkPos(glm::ivec3 blockPos)
+const WorldStats& World::GetStats()
 {
-	return glm::ivec2(floorf(blockPos.x / static_cast<float>(CHUNK_WIDTH)), floorf(blockPos.z / static_cast<float>(CHUNK_WIDTH)));
+	return _stats;
 }
 
 Player* World::GetPlayer()
@@ -435,25 +1163,46 @@ Player* World::GetPlayer()
 
 bool World::ChunkInRenderDistance(glm::ivec2 chunkPos)
 {
-	return (chunkPos[0] >= _centerChunk[0] - _renderDistance) &&
-		(chunkPos[1] >= _centerChunk[1] - _renderDistance) &&
-		(chunkPos[0] <= _centerChunk[0] + _renderDistance) &&
-		(chunkPos[1] <= _centerChunk[1] + _renderDistance);
+	return ChunkInRadius(chunkPos, _renderDistance);
+}
+
+// The render circle and, on the move, the one around where the player is heading, so those are drawn on arrival
+bool World::ChunkInMeshDistance(glm::ivec2 chunkPos)
+{
+	if (_memoryPressure)
+	{
+		return ChunkInRenderDistance(chunkPos);
+	}
+	return ChunkInRenderDistance(chunkPos) || ChunkInRadius(chunkPos - _prefetchOffset, _renderDistance);
 }
 
 bool World::ChunkInLoadDistance(glm::ivec2 chunkPos)
 {
-	return (chunkPos[0] >= _centerChunk[0] - _renderDistance - _extraLoadDistance) &&
-		(chunkPos[1] >= _centerChunk[1] - _renderDistance - _extraLoadDistance) &&
-		(chunkPos[0] <= _centerChunk[0] + _renderDistance + _extraLoadDistance) &&
-		(chunkPos[1] <= _centerChunk[1] + _renderDistance + _extraLoadDistance);
+	if (_prefetchOffset == glm::ivec2(0, 0))
+	{
+		return ChunkInRadius(chunkPos, _renderDistance + _extraLoadDistance);
+	}
+	// On the move the full margin is kept around where the player is heading; behind, only the neighbours meshing needs
+	return ChunkInRadius(chunkPos, _renderDistance + 1) ||
+		ChunkInRadius(chunkPos - _prefetchOffset, _renderDistance + _extraLoadDistance);
+}
+
+/**
+ * Circular rather than square: the corners of a square window are further away than anything else drawn and cost a
+ * fifth of the chunks. r * r + r instead of r * r keeps the single chunks sticking out at the ends of the axes.
+ */
+bool World::ChunkInRadius(glm::ivec2 chunkPos, int radius)
+{
+	glm::ivec2 offset = chunkPos - _centerChunk;
+	return offset.x * offset.x + offset.y * offset.y <= radius * radius + radius;
 }
 
-glm::ivec2 World::RelChunkIndexToAbsChunkPos(unsigned index)
+void World::UpdateProjection()
 {
-	unsigned int totalDistance = (_renderDistance * 2) + 1;
-	glm::ivec2 relPos = glm::ivec2(index % totalDistance, index / totalDistance);
-	return relPos + _chunkOrigin;
+	// The far plane has to reach the edge of the render circle once it's past the default
+	float farPlane = std::max(300.f, (_renderDistance + 2) * static_cast<float>(CHUNK_WIDTH));
+	glm::mat4 projection = glm::perspective(glm::radians(_player->_camera->_fov), 800.f / 600.f, 0.1f, farPlane);
+	_renderBackend->SetProjection(projection);
 }
 
 void World::HandleEvent(EventBase* e)
@@ -465,7 +1214,6 @@ void World::HandleEvent(EventBase* e)
 		auto clEvent = static_cast<ChunkLoadedEvent*>(e);
 		//_chunks[clEvent->_loadedChunk->_chunkPos] = clEvent->_loadedChunk;
 		clEvent->_loadedChunk->BufferMesh();
-		clEvent->_loadedChunk->_meshIsLoaded = true;
 		break;
 	}
 	default: ;
@@ -1,87 +1,189 @@
 #pragma once
 #define GLM_ENABLE_EXPERIMENTAL
 #include <array>
-#include <FastNoiseLite.h>
+#include <memory>
+#include <mutex>
 #include <queue>
+#include <vector>
 
 #include "glm/gtx/hash.hpp"
-#include "Shader.h"
 #include <unordered_map>
 
+#include "ChunkGrid.h"
+#include "ChunkMesh.h"
+#include "ChunkQueue.h"
 #include "ConcurrentRingBuffer.h"
 #include "IEventHandler.h"
+#include "IRenderBackend.h"
+#include "PendingBlockWrites.h"
+#include "TerrainNoise.h"
 
 class Player;
-class TextureAtlas;
-struct ChunkMesh;
 class ChunkTaskManager;
 class Chunk;
 class ChunkGenerator;
+class ChunkPool;
 class Camera;
+class HeightmapCache;
+
+// Counted on the main thread as results come back from the jobs
+struct WorldStats
+{
+	uint64_t chunksLoaded;
+	uint64_t meshesBuilt;
+	uint64_t chunksUnloaded;
+};
+
+struct BlockEdit
+{
+	glm::ivec3 blockPos;
+	uint8_t block;
+};
+
+// A mesh built off the main thread for a resident chunk
+struct MeshResult
+{
+	std::shared_ptr<Chunk> chunk;
+	ChunkMesh* mesh;
+};
+
+// An edited copy of a resident chunk waiting for its mesh. Masks accumulate while edits to the same chunk overlap.
+struct ChunkEdit
+{
+	std::shared_ptr<Chunk> chunk;
+	// Once the copy's state is Meshing it is read only
+	unsigned int sectionMask;
+	// Sections of the +x, -x, +z, -z neighbours to remesh once the edit is swapped in
+	std::array<unsigned int, 4> neighborSectionMasks;
+};
 
 class World : public IEventHandler
 {
+	friend class BlockAccessor;
 private:
 	static const size_t _maxJobs = 1;
+	static const size_t _maxLoadRequests = 16;
+	// 256 tiles of 4x4 chunks is 1MB and several times the area inside load distance
+	static const size_t _maxHeightmapTiles = 256;
+	// Ring buffers keep one slot empty; never have more results in flight than the output buffer can hold
+	static const size_t _maxResultsInFlight = _maxJobs * 64 - 1;
+	// Chunks this close to the center are loaded and meshed before the first frame after spawning or teleporting
+	static const int _bootstrapDistance = 4;
+	// How far ahead of the player, in seconds of travel, loading and meshing aim, and the most that can be in chunks
+	static constexpr float _prefetchSeconds = 1.f;
+	static const int _maxPrefetchChunks = 4;
 	Player* _player;
-	Shader* _shader;
 
-	std::unordered_map<glm::ivec2, std::shared_ptr<Chunk>> _chunks;
-	
+	ChunkGrid _chunks;
 
+	// Radii in chunks of the circles around _centerChunk that are drawn and kept loaded
 	uint8_t _renderDistance;
 	uint8_t _extraLoadDistance;
-	glm::ivec2 _chunkOrigin;
 	glm::ivec2 _centerChunk;
+	// Where the player is heading: smoothed x/z velocity in blocks per second and the chunk offset it leads to
+	glm::vec3 _lastPlayerPos;
+	glm::vec2 _playerVelocity;
+	glm::ivec2 _prefetchOffset;
+	// Set while MemoryBudget is over its limit, until it's back well under; only what's drawn is loaded and meshed
+	bool _memoryPressure;
+	MeshRetention _meshRetention;
+
+	WorldStats _stats;
+	size_t _loadsInFlight;
+	size_t _meshesInFlight;
+	size_t _meshUpdatesInFlight;
+	bool _bootstrapPending;
 
 public:
-	FastNoiseLite* _noiseGenerator;
+	TerrainNoise* _noiseGenerator;
+	HeightmapCache* _heightmapCache;
+	ChunkGenerator* _chunkGenerator;
+	PendingBlockWrites* _pendingWrites;
+	ChunkPool* _chunkPool;
 	ConcurrentRingBuffer<std::shared_ptr<Chunk>, _maxJobs * 64> _dataGenOutput{};
-	ConcurrentRingBuffer<std::pair<glm::ivec2, ChunkMesh*>*, _maxJobs * 64> _meshGenOutput{};
-	ConcurrentRingBuffer<std::array<unsigned int, 3>*, _maxJobs * 64> _chunkUnload{};
-
-	ConcurrentRingBuffer<std::pair<glm::ivec3, std::shared_ptr<Chunk>>*, _maxJobs * 64> _dataUpdateOutput{};
-	ConcurrentRingBuffer<std::pair<glm::ivec3, std::shared_ptr<Chunk>>*, _maxJobs * 64> _meshUpdateOutput{};
+	ConcurrentRingBuffer<MeshResult*, _maxJobs * 64> _meshGenOutput{};
+	// Buffers of destroyed chunks and the bytes uploaded to them, freed on the main thread. Unbounded: a teleport or a
+	// view distance change destroys the whole window at once, from whichever threads drop the chunks last.
+	std::mutex _releasedBuffersMutex;
+	std::vector<std::pair<ChunkRenderHandle, size_t>> _releasedBuffers;
+	ConcurrentRingBuffer<std::shared_ptr<Chunk>, _maxJobs * 64> _meshUpdateOutput{};
 	
-	std::queue<glm::ivec2> _chunksToLoad;
-	std::queue<glm::ivec2> _chunksToGenMesh;
-	std::queue<std::pair<glm::ivec3, std::shared_ptr<Chunk>>> _chunksToUpdateMesh;
+	// Nearest to _centerChunk first
+	ChunkQueue _chunksToLoad;
+	ChunkQueue _chunksToGenMesh;
+	std::queue<std::shared_ptr<Chunk>> _chunksToUpdateMesh;
+	// Newest edited copy of each chunk whose edit hasn't been swapped in yet
+	std::unordered_map<glm::ivec2, ChunkEdit> _chunkEdits;
 	
-	TextureAtlas* _textureAtlas;
+	IRenderBackend* _renderBackend;
 
-	World(Shader* shader, TextureAtlas* atlas, Player* player);
+	World(IRenderBackend* renderBackend, Player* player);
 
 	void SetCenter(glm::vec3 blockPos);
+	// Drops the whole window and rebuilds it around blockPos on the next Update
+	void Teleport(glm::vec3 blockPos);
+	// Chunks beyond the new load distance are unloaded now; the rest of the window fills in over the next frames
+	void SetViewDistance(uint8_t renderDistance, uint8_t extraLoadDistance);
+	uint8_t GetRenderDistance();
+	uint8_t GetExtraLoadDistance();
+	// Applies to meshes uploaded from now on
+	void SetMeshRetention(MeshRetention retention);
+	MeshRetention GetMeshRetention();
+	// Uploads every drawn chunk's mesh again, e.g. after the render backend lost its buffers. Chunks without a retained
+	// mesh are meshed again instead.
+	void ReuploadMeshes();
 	void UpdateBlockAtPos(glm::ivec3 blockPos, uint8_t newBlock);
+	void ApplyEdits(const std::vector<BlockEdit>& edits);
 
 	void Update(float dt);
+	// Safe from any thread; the buffers are destroyed in the next Update, and only then leave the GPU budget
+	void ReleaseChunkBuffers(const ChunkRenderHandle& handle, size_t uploadedBytes);
 	
 	void Render();
 
 	uint8_t GetBlockAtAbsPos(glm::ivec3 blockPos);
+	// out[i] = block at positions[i], air where the chunk isn't loaded
+	void GetBlocks(const glm::ivec3* positions, size_t count, uint8_t* out);
 	bool BlockInRenderDistance(glm::ivec3 blockPos);
 	glm::ivec2 BlockPosToAbsChunkPos(glm::ivec3 blockPos);
+	// True once the chunk has a mesh uploaded, i.e. is drawn when it's in view
+	bool IsChunkDrawn(glm::ivec2 chunkPos);
+	// Chunks in the grid, i.e. loaded and not unloaded since; each one owns a set of render buffers
+	size_t GetResidentChunkCount();
+
+	const WorldStats& GetStats();
 
 	Player* GetPlayer();
 	Camera* GetCamera();
-	Shader* GetShader();
+	IRenderBackend* GetRenderBackend();
 private:
 	void Init();
 	
+	void PublishMetrics();
+	void EnforceMemoryBudget();
+	void ApplyPendingWritesToResidentChunks(const std::vector<glm::ivec2>& targets);
+	void SavePendingWrites(glm::ivec2 pos, std::vector<PendingBlockWrites::Write>&& writes);
+	std::shared_ptr<Chunk> BeginChunkEdit(glm::ivec2 pos, unsigned int sectionMask);
+	void MarkBlockEdited(ChunkEdit& edit, glm::ivec3 relBlockPos);
+	void ReceiveChunkEdit(std::shared_ptr<Chunk> chunk);
+	bool GetNeighbors(glm::ivec2 pos, std::array<std::shared_ptr<Chunk>, 4>& neighbors);
+	void Bootstrap();
+	void UpdatePrefetch(float dt);
+	int GetWindowRadius();
 	void LoadNewChunks();
+	void UnloadChunk(glm::ivec2 pos);
 	void CreateLoadChunksTasks();
 	void CreateGenMeshTasks();
 	bool CreateSingleGenMeshTask(glm::ivec2 pos);
 	void CreateUpdateMeshTasks();
-	bool CreateSingleUpdateMeshTask(std::pair<glm::ivec3, std::shared_ptr<Chunk>> chunkAndPos);
+	bool CreateSingleUpdateMeshTask(std::shared_ptr<Chunk> chunk);
 	
-	unsigned int BlockPosToRelChunkIndex(glm::ivec3 blockPos);
-	unsigned int AbsChunkPosToRelIndex(glm::ivec2 chunkPos);
-	unsigned int RelChunkPosToRelIndex(glm::ivec2 chunkPos);
 	glm::ivec3 AbsBlockPosToChunkBlockPos(glm::ivec3 absBlockPos);
 	bool ChunkInRenderDistance(glm::ivec2 chunkPos);
+	bool ChunkInMeshDistance(glm::ivec2 chunkPos);
 	bool ChunkInLoadDistance(glm::ivec2 chunkPos);
-	glm::ivec2 RelChunkIndexToAbsChunkPos(unsigned int index);
+	bool ChunkInRadius(glm::ivec2 chunkPos, int radius);
+	void UpdateProjection();
 	
 public:
 	void HandleEvent(EventBase* e) override;